@@ -0,0 +1,214 @@
+#include "json_reader.h"
+#include "transport_catalogue.h"
+#include "transport_catalogue.pb.h"
+
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Checks that base_requests parsed in parallel parts give exactly the base of one pass and that
+// a corrupt base is refused.
+namespace {
+
+	int failures = 0;
+
+	void Check(bool condition, string_view what, int line) {
+		if (!condition) {
+			cerr << "base_test.cpp:"sv << line << ": "sv << what << endl;
+			++failures;
+		}
+	}
+
+	const string SETTINGS = R"("serialization_settings": {"file": "base_test.db"},
+		"routing_settings": {"bus_wait_time": 6, "bus_velocity": 40},
+		"render_settings": {"width": 1200.0, "height": 1200.0, "padding": 50.0, "line_width": 14.0,
+			"stop_radius": 5.0, "bus_label_font_size": 20, "bus_label_offset": [7.0, 15.0],
+			"stop_label_font_size": 18, "stop_label_offset": [7.0, -3.0],
+			"underlayer_color": [255, 255, 255, 0.85], "underlayer_width": 3.0,
+			"color_palette": ["green", [255, 160, 0], "red"]})"s;
+
+	string StopName(int index) {
+		// Some names need escapes, which the parts have to read like the single pass.
+		return index % 17 == 0 ? "Stop \\\"" + to_string(index) + "\\\"" : "Stop " + to_string(index);
+	}
+
+	// Stops whose road_distances and buses refer to stops all over the input, so most
+	// references cross from one part into another. Every fifth bus has the name of a
+	// stop, and every name is referred to from many places.
+	string MakeInput(int stop_count, int bus_count, unsigned seed) {
+		mt19937 random(seed);
+		uniform_int_distribution<int> stop_pick(0, stop_count - 1);
+		uniform_int_distribution<int> distance(100, 5000);
+		uniform_real_distribution<double> latitude(55.5, 55.9);
+		uniform_real_distribution<double> longitude(37.3, 37.9);
+
+		string input = "{" + SETTINGS + ", \"base_requests\": [";
+		for (int i = 0; i < stop_count + bus_count; ++i) {
+			if (i > 0) {
+				input += ",\n";
+			}
+			// Buses go between the stops, not after them.
+			if (i % 5 == 4 && i / 5 < bus_count) {
+				const int bus = i / 5;
+				const string name = bus % 5 == 0 ? StopName(stop_pick(random)) : "Bus " + to_string(bus);
+				input += "{\"type\": \"Bus\", \"name\": \"" + name + "\", \"is_roundtrip\": " + (bus % 2 == 0 ? "true" : "false") + ", \"stops\": [";
+				const int first = stop_pick(random);
+				for (int j = 0; j < 6; ++j) {
+					input += (j > 0 ? ", \"" : "\"") + StopName(j == 0 || (j == 5 && bus % 2 == 0) ? first : stop_pick(random)) + "\"";
+				}
+				input += "]}";
+				continue;
+			}
+			const int stop = i - min(i / 5, bus_count);
+			input += "{\"type\": \"Stop\", \"name\": \"" + StopName(stop) + "\", \"latitude\": " + to_string(latitude(random))
+				+ ", \"longitude\": " + to_string(longitude(random)) + ", \"road_distances\": {";
+			for (int j = 0; j < 3; ++j) {
+				input += (j > 0 ? ", \"" : "\"") + StopName(stop_pick(random)) + "\": " + to_string(distance(random));
+			}
+			input += "}}";
+		}
+		return input + "]}";
+	}
+
+	// Everything LoadBase returns, names by their ids, as text.
+	string Dump(const json::reader::BaseData& base) {
+		string text;
+		for (transport::domains::NamePool::Id id = 0; id < base.names.Size(); ++id) {
+			text += string(base.names.GetName(id)) + "|";
+		}
+		text += "\n";
+		for (const auto& stop : base.stops) {
+			text += string(stop.name) + " " + to_string(stop.coordinates.lat) + " " + to_string(stop.coordinates.lng);
+			for (const auto& [to, distance] : stop.road_distanse) {
+				text += " " + to_string(to) + ":" + to_string(distance);
+			}
+			text += "\n";
+		}
+		for (const auto& bus : base.buses) {
+			text += string(bus.name) + (bus.is_roundtrip ? " R" : " L");
+			for (const auto stop : bus.stops) {
+				text += " " + to_string(stop);
+			}
+			text += "\n";
+		}
+		return text + base.serialization_file;
+	}
+
+	string Serialize(json::reader::BaseData base) {
+		transport::catalogue::TransportCatalogue catalogue(std::move(base.names), std::move(base.stops), std::move(base.buses),
+			base.render_settings, base.routing_settings);
+		return catalogue.Serialize();
+	}
+
+	string LoadOrError(const string& input, size_t parts) {
+		try {
+			return Dump(json::reader::LoadBase(input, parts));
+		}
+		catch (const exception& error) {
+			return "error: "s + error.what();
+		}
+	}
+
+	void TestParts() {
+		for (const unsigned seed : { 1u, 2u, 3u }) {
+			const string input = MakeInput(400, 80, seed);
+			const json::reader::BaseData expected = json::reader::LoadBase(input, 1);
+			const string expected_dump = Dump(expected);
+			const string expected_base = Serialize(json::reader::LoadBase(input, 1));
+
+			for (const size_t parts : { 2, 3, 4, 7, 16, 1000 }) {
+				const string what = "seed " + to_string(seed) + ", " + to_string(parts) + " parts";
+				Check(Dump(json::reader::LoadBase(input, parts)) == expected_dump, what + ": same base data", __LINE__);
+				Check(Serialize(json::reader::LoadBase(input, parts)) == expected_base, what + ": same serialized base", __LINE__);
+			}
+		}
+	}
+
+	// What the split does not expect is left to the single pass, errors included.
+	void TestFallback() {
+		const string stop = R"({"type": "Stop", "name": "A", "latitude": 55.6, "longitude": 37.6})";
+		for (const string& input : {
+			"{" + SETTINGS + ", \"base_requests\": [" + stop + "], \"base_requests\": [" + stop + "]}",
+			"{" + SETTINGS + ", \"base_requests\": [" + stop + "],}",
+			"{" + SETTINGS + " \"base_requests\": [" + stop + "]}",
+			"{\"base_\\u0072equests\": [" + stop + "], " + SETTINGS + "}",
+			"{" + SETTINGS + ", \"base_requests\": [" + stop + ", {\"type\": \"Tram\", \"name\": \"T\"}]}",
+			"{" + SETTINGS + ", \"base_requests\": []}",
+			"[" + stop + "]" }) {
+			const string expected = LoadOrError(input, 1);
+			Check(LoadOrError(input, 4) == expected, "4 parts read like one: " + input.substr(input.size() - 40), __LINE__);
+		}
+	}
+
+	// Ids past the stops, buses or names they refer to.
+	void TestCorruptBase() {
+		TCProto::TransportCatalogue base;
+		Check(base.ParseFromString(Serialize(json::reader::LoadBase(MakeInput(40, 10, 4), 1))), "the base parses", __LINE__);
+		const uint32_t stop_count = base.map_stops_size();
+		const uint32_t bus_count = base.map_buses_size();
+
+		const vector<pair<string, function<void(TCProto::TransportCatalogue&)>>> corruptions = {
+			{ "stop of a bus", [stop_count](TCProto::TransportCatalogue& proto) {
+				proto.mutable_map_buses(3)->set_stop_ids(1, stop_count);
+			} },
+			{ "bus of a stop", [bus_count](TCProto::TransportCatalogue& proto) {
+				proto.mutable_map_stops(0)->add_bus_ids(bus_count);
+			} },
+			{ "name of a stop", [](TCProto::TransportCatalogue& proto) {
+				proto.mutable_map_stops(1)->set_name_id(proto.names_size());
+			} },
+			{ "name of a bus", [](TCProto::TransportCatalogue& proto) {
+				proto.mutable_map_buses(1)->set_name_id(proto.names_size() + 100);
+			} },
+			{ "road distance without its stops", [](TCProto::TransportCatalogue& proto) {
+				proto.mutable_road_distances()->add_distance(100);
+			} },
+			{ "stop of a route item", [stop_count](TCProto::TransportCatalogue& proto) {
+				proto.mutable_router()->mutable_graph_edges(0)->set_start_stop_id(stop_count);
+			} },
+			{ "bus of a route item", [bus_count](TCProto::TransportCatalogue& proto) {
+				proto.mutable_router()->mutable_graph_edges(0)->set_bus_id(bus_count);
+			} },
+		};
+
+		for (const auto& [what, corrupt] : corruptions) {
+			TCProto::TransportCatalogue proto = base;
+			corrupt(proto);
+			string error;
+			try {
+				transport::catalogue::TransportCatalogue().Deserialize(proto.SerializeAsString());
+			}
+			catch (const runtime_error& e) {
+				error = e.what();
+			}
+			Check(error.find("invalid serialized") == 0, what + ": refused", __LINE__);
+		}
+
+		string error = "none";
+		try {
+			transport::catalogue::TransportCatalogue().Deserialize(base.SerializeAsString());
+		}
+		catch (const exception& e) {
+			error = e.what();
+		}
+		Check(error == "none", "the intact base loads: " + error, __LINE__);
+	}
+
+}
+
+int main() {
+	TestParts();
+	TestFallback();
+	TestCorruptBase();
+
+	if (failures > 0) {
+		cerr << failures << " checks failed"sv << endl;
+		return 1;
+	}
+	cout << "base_test OK"sv << endl;
+	return 0;
+}
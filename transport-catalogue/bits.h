@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Bit counting that compiles to one instruction on GCC, Clang and MSVC and falls back
+// to a loop elsewhere.
+namespace bits {
+
+	// The index of the lowest set bit; value must not be zero.
+	inline int CountTrailingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index = 0;
+		_BitScanForward64(&index, value);
+		return static_cast<int>(index);
+#else
+		int count = 0;
+		while ((value & 1) == 0) {
+			value >>= 1;
+			++count;
+		}
+		return count;
+#endif
+	}
+
+	inline int PopCount(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_popcountll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		return static_cast<int>(__popcnt64(value));
+#else
+		int count = 0;
+		for (; value != 0; value &= value - 1) {
+			++count;
+		}
+		return count;
+#endif
+	}
+
+}
@@ -1,42 +1,120 @@
 #include "domain.h"
+#include "bits.h"
+
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <ostream>
+#include <stdexcept>
 
 namespace transport::domains {
 	using namespace std::literals;
 
-	void Stop::Parse(const json::Dict& request) {
-		name = request.at("name"s).AsString();
-		coordinates = {
-			request.at("latitude"s).AsDouble(),
-			request.at("longitude"s).AsDouble()
-		};
+	std::string_view NamePool::Intern(std::string_view name) {
+		return names_[InternId(name)];
+	}
+
+	NamePool::Id NamePool::InternId(std::string_view name) {
+		IndexAll();
+		if (auto it = ids_.find(name); it != ids_.end()) {
+			return it->second;
+		}
+
+		const Id id = Append(name);
+		ids_.emplace(names_[id], id);
+		indexed_count_ = names_.size();
+		return id;
+	}
 
-		for (const auto& [stop_name, distance] : request.at("road_distances"s).AsMap()) {
-			road_distanse[stop_name] = distance.AsInt();
+	NamePool::Id NamePool::Append(std::string_view name) {
+		// Names longer than a block get a block of their own.
+		if (block_pos_ == nullptr || name.size() > block_free_) {
+			const size_t size = std::max(name.size(), BLOCK_SIZE);
+			blocks_.push_back(std::make_unique<char[]>(size));
+			block_pos_ = blocks_.back().get();
+			block_free_ = size;
 		}
+		char* data = block_pos_;
+		std::memcpy(data, name.data(), name.size());
+		block_pos_ += name.size();
+		block_free_ -= name.size();
+
+		const std::string_view stored(data, name.size());
+		const Id id = static_cast<Id>(names_.size());
+		names_.push_back(stored);
+		return id;
+	}
+
+	NamePool::Id NamePool::GetId(std::string_view name) const {
+		auto it = ids_.find(name);
+		if (it == ids_.end()) throw std::out_of_range("unknown name"s);
+		return it->second;
+	}
+
+	std::string_view NamePool::GetName(Id id) const {
+		return names_.at(id);
 	}
 
-	void Bus::Parse(const json::Dict& request) {
-		name = request.at("name"s).AsString();
-		is_roundtrip = request.at("is_roundtrip"s).AsBool();
+	size_t NamePool::Size() const {
+		return names_.size();
+	}
 
-		for (const auto& stop_name : request.at("stops"s).AsArray()) {
-			stops.push_back(stop_name.AsString());
+	void NamePool::IndexAll() {
+		for (; indexed_count_ < names_.size(); ++indexed_count_) {
+			ids_.emplace(names_[indexed_count_], static_cast<Id>(indexed_count_));
 		}
 	}
 
-	int RealLenBeetwenStops(std::shared_ptr<Stop> from, std::shared_ptr<Stop> to) {
-		if (from == nullptr || to == nullptr) throw std::invalid_argument("stops no find");
+	void RoadDistances::Reserve(size_t count) {
+		while (slots_.size() < count * 2) {
+			Grow();
+		}
+	}
 
-		auto it = from->road_distanse.find(to->name);
-		if (it != from->road_distanse.end()) return it->second;
+	void RoadDistances::Set(StopId from, StopId to, int distance) {
+		Find(Key(from, to)).distance = distance;
+	}
 
-		it = to->road_distanse.find(from->name);
-		if (it != to->road_distanse.end()) return it->second;
+	void RoadDistances::SetIfMissing(StopId from, StopId to, int distance) {
+		const size_t size = size_;
+		Slot& slot = Find(Key(from, to));
+		if (size_ != size) {
+			slot.distance = distance;
+		}
+	}
 
-		return 0;
+	// The slot of key, taken for it if the key is new.
+	RoadDistances::Slot& RoadDistances::Find(uint64_t key) {
+		// At most half of the slots are used, which keeps probes short.
+		if ((size_ + 1) * 2 > slots_.size()) {
+			Grow();
+		}
+		for (size_t index = Home(key);; index = (index + 1) & mask_) {
+			Slot& slot = slots_[index];
+			if (slot.key == key) {
+				return slot;
+			}
+			if (slot.key == EMPTY) {
+				slot.key = key;
+				++size_;
+				return slot;
+			}
+		}
+	}
+
+	void RoadDistances::Grow() {
+		std::vector<Slot> old = std::move(slots_);
+		const size_t capacity = old.empty() ? 16 : old.size() * 2;
+		slots_.assign(capacity, Slot{});
+		mask_ = capacity - 1;
+		shift_ = 64 - bits::CountTrailingZeros(capacity);
+		size_ = 0;
+		for (const Slot& slot : old) {
+			if (slot.key != EMPTY) {
+				Find(slot.key).distance = slot.distance;
+			}
+		}
 	}
 	
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "geo.h"
 #include "json.h"
 
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -10,24 +12,62 @@
 #include <map>
 #include <memory>
 #include <ostream>
+#include <unordered_map>
 
 namespace transport::domains {
 
+	// Dense numbers of stops and buses in the catalogue, given in the order of their names.
+	using StopId = uint32_t;
+	using BusId = uint32_t;
+	inline constexpr uint32_t NO_ID = std::numeric_limits<uint32_t>::max();
+
+	// Stores every stop and bus name once and numbers them in the order they are added.
+	// Views into the pool stay valid while the pool lives, also after it is moved.
+	class NamePool {
+	public:
+		using Id = uint32_t;
+
+		std::string_view Intern(std::string_view name);
+		Id InternId(std::string_view name);
+		// For names known to be new, such as those of a saved pool: adds the name without
+		// hashing it. Intern hashes the names added so on its first call; GetId only finds
+		// them after IndexAll.
+		Id Append(std::string_view name);
+		void IndexAll();
+
+		// Does not change the pool, so it may be called from several threads at once.
+		Id GetId(std::string_view name) const;
+		std::string_view GetName(Id id) const;
+		size_t Size() const;
+
+	private:
+		static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+		std::vector<std::unique_ptr<char[]>> blocks_;
+		char* block_pos_ = nullptr;
+		size_t block_free_ = 0;
+
+		std::vector<std::string_view> names_;
+		std::unordered_map<std::string_view, Id> ids_;
+		size_t indexed_count_ = 0;
+	};
+
 	struct Stop {
 		Stop() = default;
 
-		std::string name;
+		std::string_view name;
 		geo::Coordinates coordinates;
-		std::map<std::string, int> road_distanse;
-		std::set<std::string> buses;
-
-		void Parse(const json::Dict& request);
+		// As given in the input: the name ids of the neighbouring stops in the NamePool
+		// and the distances to them. The catalogue moves them into its RoadDistances.
+		std::vector<std::pair<NamePool::Id, int>> road_distanse;
+		// Sorted, which is also the order of the bus names.
+		std::vector<BusId> buses;
 	};
 
 	struct Bus {
 		Bus() = default;
 
-		std::string name;
+		std::string_view name;
 
 		bool is_roundtrip;
 		int stop_count = 0;
@@ -35,13 +75,80 @@ namespace transport::domains {
 		double route_length = 0.0;
 		double curvature = 0.0;
 
-		std::vector<std::string> stops;
-
-		void Parse(const json::Dict& request);
+		// Until the catalogue is built these are the ids of the stop names in the NamePool.
+		std::vector<StopId> stops;
 	};
 
 
-	int RealLenBeetwenStops(std::shared_ptr<Stop> from, std::shared_ptr<Stop> to);
+	// Road distances between stops in one open-addressing table keyed by the pair of stop
+	// ids packed into 64 bits. Get is a hash and a short probe without allocations.
+	class RoadDistances {
+	public:
+		// Makes room for count pairs at once.
+		void Reserve(size_t count);
+
+		// Overwrites the distance stored for the pair, if any.
+		void Set(StopId from, StopId to, int distance);
+		// Keeps the distance stored for the pair, if any.
+		void SetIfMissing(StopId from, StopId to, int distance);
+
+		// 0 when there is no distance between the stops.
+		int Get(StopId from, StopId to) const {
+			if (slots_.empty()) {
+				return 0;
+			}
+			const uint64_t key = Key(from, to);
+			for (size_t index = Home(key);; index = (index + 1) & mask_) {
+				const Slot& slot = slots_[index];
+				if (slot.key == key) {
+					return slot.distance;
+				}
+				if (slot.key == EMPTY) {
+					return 0;
+				}
+			}
+		}
+
+		size_t Size() const {
+			return size_;
+		}
+
+		// Calls func(from, to, distance) for every pair, in table order.
+		template <typename Func>
+		void ForEach(Func func) const {
+			for (const Slot& slot : slots_) {
+				if (slot.key != EMPTY) {
+					func(static_cast<StopId>(slot.key >> 32), static_cast<StopId>(slot.key), slot.distance);
+				}
+			}
+		}
+
+	private:
+		// Both ids NO_ID, which no real pair has.
+		static constexpr uint64_t EMPTY = std::numeric_limits<uint64_t>::max();
+
+		struct Slot {
+			uint64_t key = EMPTY;
+			int distance = 0;
+		};
+
+		static uint64_t Key(StopId from, StopId to) {
+			return uint64_t{ from } << 32 | to;
+		}
+
+		// Fibonacci hashing: the top bits of the product spread consecutive ids well.
+		size_t Home(uint64_t key) const {
+			return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+		}
+
+		Slot& Find(uint64_t key);
+		void Grow();
+
+		std::vector<Slot> slots_;
+		size_t mask_ = 0;
+		int shift_ = 64;
+		size_t size_ = 0;
+	};
 
 
 	
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "geo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace geo {
+
+    inline constexpr double METERS_PER_DEGREE = 6371000 * 3.1415926535 / 180.;
+
+    // Uniform lat/lng grid over a fixed set of points. Cells are about cell_size meters wide,
+    // so a radius query only looks at the few cells around the bounding box of the circle.
+    class GridIndex {
+    public:
+        GridIndex() = default;
+
+        GridIndex(std::vector<Coordinates> points, double cell_size)
+            : points_(std::move(points))
+            , lat_step_(std::max(cell_size, 1.0) / METERS_PER_DEGREE)
+        {
+            if (points_.empty()) {
+                return;
+            }
+
+            const auto [min_lat, max_lat] = std::minmax_element(points_.begin(), points_.end(), [](const Coordinates& lhs, const Coordinates& rhs) {
+                return lhs.lat < rhs.lat;
+                });
+            const double widest_lat = std::max(std::abs(min_lat->lat), std::abs(max_lat->lat));
+            lng_step_ = lat_step_ / std::max(std::cos(widest_lat * 3.1415926535 / 180.), 0.01);
+
+            min_row_ = max_row_ = Row(points_.front().lat);
+            min_column_ = max_column_ = Column(points_.front().lng);
+            for (size_t index = 0; index < points_.size(); ++index) {
+                const int64_t row = Row(points_[index].lat);
+                const int64_t column = Column(points_[index].lng);
+                min_row_ = std::min(min_row_, row);
+                max_row_ = std::max(max_row_, row);
+                min_column_ = std::min(min_column_, column);
+                max_column_ = std::max(max_column_, column);
+                cells_[Key(row, column)].push_back(index);
+            }
+        }
+
+        // Calls visit(index, distance) for every point within radius meters of center.
+        template <typename Visitor>
+        void ForEachInRadius(Coordinates center, double radius, Visitor visit) const {
+            if (points_.empty()) {
+                return;
+            }
+
+            const double lat_radius = radius / METERS_PER_DEGREE;
+            const double lng_radius = lat_radius * (lng_step_ / lat_step_);
+            for (int64_t row = Row(center.lat - lat_radius); row <= Row(center.lat + lat_radius); ++row) {
+                for (int64_t column = Column(center.lng - lng_radius); column <= Column(center.lng + lng_radius); ++column) {
+                    auto it = cells_.find(Key(row, column));
+                    if (it == cells_.end()) {
+                        continue;
+                    }
+                    for (const size_t index : it->second) {
+                        const double distance = Distance(center, points_[index]);
+                        if (distance <= radius) {
+                            visit(index, distance);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Returns up to count points closest to center as (index, distance) sorted by distance.
+        // Rings of cells are scanned outwards until no unseen cell can hold a closer point.
+        std::vector<std::pair<size_t, double>> Nearest(Coordinates center, size_t count) const {
+            std::vector<std::pair<size_t, double>> found;
+            if (points_.empty() || count == 0) {
+                return found;
+            }
+
+            const int64_t center_row = Row(center.lat);
+            const int64_t center_column = Column(center.lng);
+            const int64_t max_ring = std::max({ std::abs(center_row - min_row_), std::abs(center_row - max_row_),
+                std::abs(center_column - min_column_), std::abs(center_column - max_column_) });
+            const double ring_width = lat_step_ * METERS_PER_DEGREE;
+
+            auto by_distance = [](const std::pair<size_t, double>& lhs, const std::pair<size_t, double>& rhs) {
+                return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+            };
+
+            const int64_t first_ring = std::max<int64_t>({ 0, min_row_ - center_row, center_row - max_row_,
+                min_column_ - center_column, center_column - max_column_ });
+
+            for (int64_t ring = first_ring; ring <= max_ring; ++ring) {
+                if (found.size() >= count && found[count - 1].second <= (ring - 1) * ring_width) {
+                    break;
+                }
+                const int64_t row_begin = std::max(center_row - ring, min_row_);
+                const int64_t row_end = std::min(center_row + ring, max_row_);
+                for (int64_t row = row_begin; row <= row_end; ++row) {
+                    const bool edge_row = row == center_row - ring || row == center_row + ring;
+                    if (edge_row) {
+                        const int64_t column_end = std::min(center_column + ring, max_column_);
+                        for (int64_t column = std::max(center_column - ring, min_column_); column <= column_end; ++column) {
+                            CollectCell(row, column, center, found);
+                        }
+                    }
+                    else {
+                        CollectCell(row, center_column - ring, center, found);
+                        CollectCell(row, center_column + ring, center, found);
+                    }
+                }
+                std::sort(found.begin(), found.end(), by_distance);
+            }
+
+            if (found.size() > count) {
+                found.resize(count);
+            }
+            return found;
+        }
+
+        const std::vector<Coordinates>& GetPoints() const {
+            return points_;
+        }
+
+        // ComputeDistance returns NaN for (almost) equal points because of rounding inside acos.
+        static double Distance(Coordinates from, Coordinates to) {
+            const double distance = ComputeDistance(from, to);
+            return distance >= 0 ? distance : 0.0;
+        }
+
+    private:
+        void CollectCell(int64_t row, int64_t column, Coordinates center, std::vector<std::pair<size_t, double>>& found) const {
+            auto it = cells_.find(Key(row, column));
+            if (it == cells_.end()) {
+                return;
+            }
+            for (const size_t index : it->second) {
+                found.push_back({ index, Distance(center, points_[index]) });
+            }
+        }
+
+        int64_t Row(double lat) const {
+            return static_cast<int64_t>(std::floor(lat / lat_step_));
+        }
+
+        int64_t Column(double lng) const {
+            return static_cast<int64_t>(std::floor(lng / lng_step_));
+        }
+
+        static uint64_t Key(int64_t row, int64_t column) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(row)) << 32) | static_cast<uint32_t>(column);
+        }
+
+        std::vector<Coordinates> points_;
+        double lat_step_ = 1.0;
+        double lng_step_ = 1.0;
+        int64_t min_row_ = 0;
+        int64_t max_row_ = 0;
+        int64_t min_column_ = 0;
+        int64_t max_column_ = 0;
+        std::unordered_map<uint64_t, std::vector<size_t>> cells_;
+    };
+
+}
@@ -4,12 +4,18 @@
 
 #include "graph.pb.h"
 
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace graph {
-    using VertexId = size_t;
-    using EdgeId = size_t;
+    // 32-bit ids keep an edge with a 32-bit weight at 12 bytes and halve the incidence lists.
+    using VertexId = uint32_t;
+    using EdgeId = uint32_t;
 
     template <typename Weight>
     struct Edge {
@@ -27,6 +33,7 @@ namespace graph {
     public:
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
+        DirectedWeightedGraph(size_t vertex_count, std::vector<Edge<Weight>> edges);
         EdgeId AddEdge(const Edge<Weight>& edge);
 
         size_t GetVertexCount() const;
@@ -48,10 +55,25 @@ namespace graph {
         : incidence_lists_(vertex_count) {
     }
 
+    template <typename Weight>
+    DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count, std::vector<Edge<Weight>> edges)
+        : edges_(std::move(edges))
+        , incidence_lists_(vertex_count) {
+        if (edges_.size() > std::numeric_limits<EdgeId>::max() || vertex_count > std::numeric_limits<VertexId>::max()) {
+            throw std::length_error("too many edges or vertexes for 32-bit ids");
+        }
+        for (EdgeId id = 0; id < edges_.size(); ++id) {
+            incidence_lists_.at(edges_[id].from).push_back(id);
+        }
+    }
+
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+        if (edges_.size() == std::numeric_limits<EdgeId>::max()) {
+            throw std::length_error("too many edges for 32-bit ids");
+        }
         edges_.push_back(edge);
-        const EdgeId id = edges_.size() - 1;
+        const EdgeId id = static_cast<EdgeId>(edges_.size() - 1);
         incidence_lists_.at(edge.from).push_back(id);
         return id;
     }
@@ -83,7 +105,12 @@ namespace graph {
             auto& edge_proto = *proto.add_edges();
             edge_proto.set_from(edge.from);
             edge_proto.set_to(edge.to);
-            edge_proto.set_weight(edge.weight);
+            if constexpr (std::is_integral_v<Weight>) {
+                edge_proto.set_fixed_weight(edge.weight);
+            }
+            else {
+                edge_proto.set_weight(edge.weight);
+            }
         }
 
         for (const auto& incidence_list : incidence_lists_) {
@@ -104,7 +131,12 @@ namespace graph {
             auto& edge = graph.edges_.emplace_back();
             edge.from = edge_proto.from();
             edge.to = edge_proto.to();
-            edge.weight = edge_proto.weight();
+            if constexpr (std::is_integral_v<Weight>) {
+                edge.weight = static_cast<Weight>(edge_proto.fixed_weight());
+            }
+            else {
+                edge.weight = edge_proto.weight();
+            }
         }
 
         graph.incidence_lists_.reserve(proto.incidence_lists_size());
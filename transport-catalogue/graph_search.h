@@ -0,0 +1,88 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    template <typename Weight>
+    struct PathInfo {
+        Weight weight;
+        VertexId source;
+        VertexId target;
+        std::vector<EdgeId> edges;
+    };
+
+    // One Dijkstra run from several sources, each with its own starting weight, to the cheapest
+    // of several targets, each with its own finishing weight.
+    template <typename Weight>
+    std::optional<PathInfo<Weight>> FindBestPath(
+        const DirectedWeightedGraph<Weight>& graph,
+        const std::vector<std::pair<VertexId, Weight>>& sources,
+        const std::vector<std::pair<VertexId, Weight>>& targets
+    ) {
+        constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::max();
+        const size_t vertex_count = graph.GetVertexCount();
+
+        std::vector<Weight> distance(vertex_count, INFINITE_WEIGHT);
+        std::vector<std::optional<EdgeId>> prev_edge(vertex_count);
+        std::vector<Weight> finish(vertex_count, INFINITE_WEIGHT);
+        for (const auto& [vertex, weight] : targets) {
+            finish[vertex] = std::min(finish[vertex], weight);
+        }
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        for (const auto& [vertex, weight] : sources) {
+            if (weight < distance[vertex]) {
+                distance[vertex] = weight;
+                queue.push({ weight, vertex });
+            }
+        }
+
+        std::optional<std::pair<Weight, VertexId>> best;
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight != distance[vertex]) {
+                continue;
+            }
+            if (best && weight >= best->first) {
+                break;
+            }
+            if (finish[vertex] != INFINITE_WEIGHT && (!best || weight + finish[vertex] < best->first)) {
+                best = { weight + finish[vertex], vertex };
+            }
+
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const auto& edge = graph.GetEdge(edge_id);
+                const Weight candidate = weight + edge.weight;
+                if (candidate < distance[edge.to]) {
+                    distance[edge.to] = candidate;
+                    prev_edge[edge.to] = edge_id;
+                    queue.push({ candidate, edge.to });
+                }
+            }
+        }
+
+        if (!best) {
+            return std::nullopt;
+        }
+
+        PathInfo<Weight> path{ best->first, best->second, best->second, {} };
+        for (std::optional<EdgeId> edge_id = prev_edge[path.target]; edge_id; edge_id = prev_edge[path.source]) {
+            path.edges.push_back(*edge_id);
+            path.source = graph.GetEdge(*edge_id).from;
+        }
+        std::reverse(path.edges.begin(), path.edges.end());
+        return path;
+    }
+
+}
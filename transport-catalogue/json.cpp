@@ -1,5 +1,10 @@
 #include "json.h"
+#include "json_writer.h"
 
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
 #include <cwctype>
 #include <array>
 #include <iomanip>
@@ -12,187 +17,560 @@ namespace json {
 
 	using Number = std::variant<int, double>;
 
-	Node LoadNode(istream& input);
+	namespace {
 
-	Node LoadArray(istream& input) {
-		Array result;
-		char c;
-		while (input >> c) {
-			if (c == ']') {
-				return Node(move(result));
+		void AppendUtf8(string& line, uint32_t code) {
+			if (code < 0x80) {
+				line.push_back(static_cast<char>(code));
+			}
+			else if (code < 0x800) {
+				line.push_back(static_cast<char>(0xC0 | (code >> 6)));
+				line.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			else if (code < 0x10000) {
+				line.push_back(static_cast<char>(0xE0 | (code >> 12)));
+				line.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				line.push_back(static_cast<char>(0x80 | (code & 0x3F)));
 			}
-			if (c != ',') {
-				input.putback(c);
+			else {
+				line.push_back(static_cast<char>(0xF0 | (code >> 18)));
+				line.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+				line.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				line.push_back(static_cast<char>(0x80 | (code & 0x3F)));
 			}
-			result.push_back(LoadNode(input));
 		}
-		throw json::ParsingError("Parsing: Array error"s);
-	}
 
-	Number LoadNumber(std::istream& input) {
-		using namespace std::literals;
+		// Single pass recursive descent over a contiguous buffer.
+		class Parser {
+		public:
+			explicit Parser(std::string_view input)
+				: begin_(input.data())
+				, pos_(input.data())
+				, end_(input.data() + input.size()) {}
 
-		std::string parsed_num;
+			Node ParseNode() {
+				SkipSpaces();
+				if (pos_ == end_) {
+					throw ParsingError("Unexpected end of input"s);
+				}
 
-		auto read_char = [&parsed_num, &input] {
-			parsed_num += static_cast<char>(input.get());
-			if (!input) {
-				throw ParsingError("Failed to read number from stream"s);
+				switch (*pos_) {
+				case '[':
+					++pos_;
+					return ParseArray();
+				case '{':
+					++pos_;
+					return ParseDict();
+				case '"':
+					++pos_;
+					return Node(string(ParseString()));
+				case 't':
+					ParseLiteral("true"sv);
+					return Node(true);
+				case 'f':
+					ParseLiteral("false"sv);
+					return Node(false);
+				case 'n':
+					ParseLiteral("null"sv);
+					return Node(nullptr);
+				default:
+					return std::visit([](auto value) { return Node(value); }, ParseNumber());
+				}
 			}
-		};
 
-		auto read_digits = [&input, read_char] {
-			if (!std::isdigit(input.peek())) {
-				throw ParsingError("A digit is expected"s);
+			void ParseEvents(SaxHandler& handler) {
+				SkipSpaces();
+				if (pos_ == end_) {
+					throw ParsingError("Unexpected end of input"s);
+				}
+
+				switch (*pos_) {
+				case '[':
+					++pos_;
+					handler.StartArray();
+					if (!TryConsume(']')) {
+						do {
+							ParseEvents(handler);
+						} while (Expect(",]"sv, "Parsing: Array error") == ',');
+					}
+					handler.EndArray();
+					break;
+				case '{':
+					++pos_;
+					handler.StartDict();
+					if (!TryConsume('}')) {
+						do {
+							Expect("\""sv, "Map parsing error");
+							handler.Key(ParseString());
+							Expect(":"sv, "Map parsing error");
+							ParseEvents(handler);
+						} while (Expect(",}"sv, "Map parsing error") == ',');
+					}
+					handler.EndDict();
+					break;
+				case '"':
+					++pos_;
+					handler.String(ParseString());
+					break;
+				case 't':
+					ParseLiteral("true"sv);
+					handler.Bool(true);
+					break;
+				case 'f':
+					ParseLiteral("false"sv);
+					handler.Bool(false);
+					break;
+				case 'n':
+					ParseLiteral("null"sv);
+					handler.Null();
+					break;
+				default:
+					if (const Number number = ParseNumber(); std::holds_alternative<int>(number)) {
+						handler.Int(std::get<int>(number));
+					}
+					else {
+						handler.Double(std::get<double>(number));
+					}
+				}
 			}
-			while (std::isdigit(input.peek())) {
-				read_char();
+
+			void ParseSequenceEvents(SaxHandler& handler) {
+				SkipSpaces();
+				while (pos_ != end_) {
+					ParseEvents(handler);
+					SkipSpaces();
+					if (pos_ != end_) {
+						Expect(","sv, "Parsing: Array error");
+					}
+				}
 			}
-		};
 
-		if (input.peek() == '-') {
-			read_char();
-		}
-		if (input.peek() == '0') {
-			read_char();
-		}
-		else {
-			read_digits();
-		}
+			// The whole input has to be one number.
+			Number ParseWholeNumber() {
+				const Number number = ParseNumber();
+				if (pos_ != end_) {
+					throw ParsingError("Invalid scalar"s);
+				}
+				return number;
+			}
 
-		bool is_int = true;
-		if (input.peek() == '.') {
-			read_char();
-			read_digits();
-			is_int = false;
-		}
+		private:
+			void SkipSpaces() {
+				while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t')) {
+					++pos_;
+				}
+			}
 
-		if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-			read_char();
-			if (ch = input.peek(); ch == '+' || ch == '-') {
-				read_char();
+			// Skips spaces and consumes the next character, which must be one of expected.
+			char Expect(std::string_view expected, const char* error) {
+				SkipSpaces();
+				if (pos_ == end_ || expected.find(*pos_) == std::string_view::npos) {
+					throw ParsingError(error);
+				}
+				return *pos_++;
 			}
-			read_digits();
-			is_int = false;
-		}
 
-		try {
-			if (is_int) {
+			bool TryConsume(char c) {
+				SkipSpaces();
+				if (pos_ != end_ && *pos_ == c) {
+					++pos_;
+					return true;
+				}
+				return false;
+			}
 
-				try {
-					return std::stoi(parsed_num);
+			Node ParseArray() {
+				Array result;
+				if (TryConsume(']')) {
+					return Node(move(result));
 				}
-				catch (...) {}
+				do {
+					result.push_back(ParseNode());
+				} while (Expect(",]"sv, "Parsing: Array error") == ',');
+				return Node(move(result));
 			}
-			return std::stod(parsed_num);
-		}
-		catch (...) {
-			throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-		}
-	}
 
-	Node LoadString(istream& input) {
-		string line;
-		for (char c; input >> std::noskipws >> c;) {
-			if (c == '"') {
-				input >> std::skipws;
-				return Node(move(line));
+			Node ParseDict() {
+				Dict result;
+				if (TryConsume('}')) {
+					return Node(move(result));
+				}
+				do {
+					Expect("\""sv, "Map parsing error");
+					string key(ParseString());
+					Expect(":"sv, "Map parsing error");
+					result.insert({ move(key), ParseNode() });
+				} while (Expect(",}"sv, "Map parsing error") == ',');
+				return Node(move(result));
 			}
-			if (c == '\\') {
-				input >> c;
-				switch (c) {
-				case '"': line.push_back('"'); break;
-				case 'n': line.push_back('\n'); break;
-				case 'r': line.push_back('\r'); break;
-				case '\\': line.push_back('\\'); break;
-				case 't': line.push_back('\t'); break;
+
+			// Called after the opening quote. A string without escapes is returned as a view
+			// into the input; otherwise it is unescaped into scratch_, valid until the next call.
+			std::string_view ParseString() {
+				const char* begin = pos_;
+				while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\') {
+					++pos_;
+				}
+				if (pos_ == end_) {
+					throw ParsingError("String parsing error"s);
+				}
+				if (*pos_ == '"') {
+					return std::string_view(begin, pos_++ - begin);
+				}
+
+				string& line = scratch_;
+				line.assign(begin, pos_);
+				while (true) {
+					const char* run = pos_;
+					while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\') {
+						++pos_;
+					}
+					line.append(run, pos_);
+					if (pos_ == end_) {
+						throw ParsingError("String parsing error"s);
+					}
+					if (*pos_++ == '"') {
+						return line;
+					}
+					if (pos_ == end_) {
+						throw ParsingError("String parsing error"s);
+					}
+					switch (*pos_++) {
+					case '"': line.push_back('"'); break;
+					case '\\': line.push_back('\\'); break;
+					case '/': line.push_back('/'); break;
+					case 'b': line.push_back('\b'); break;
+					case 'f': line.push_back('\f'); break;
+					case 'n': line.push_back('\n'); break;
+					case 'r': line.push_back('\r'); break;
+					case 't': line.push_back('\t'); break;
+					case 'u': AppendUtf8(line, ParseCodePoint()); break;
+					default:
+						throw ParsingError("bad string"s);
+					}
+				}
+			}
+
+			uint32_t ParseHex4() {
+				if (end_ - pos_ < 4) {
+					throw ParsingError("bad string"s);
+				}
+				uint32_t code = 0;
+				for (int i = 0; i < 4; ++i) {
+					const char c = *pos_++;
+					code <<= 4;
+					if (c >= '0' && c <= '9') code |= c - '0';
+					else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+					else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+					else throw ParsingError("bad string"s);
+				}
+				return code;
+			}
+
+			uint32_t ParseCodePoint() {
+				uint32_t code = ParseHex4();
+				if (code >= 0xD800 && code < 0xDC00 && end_ - pos_ >= 2 && pos_[0] == '\\' && pos_[1] == 'u') {
+					pos_ += 2;
+					const uint32_t low = ParseHex4();
+					if (low < 0xDC00 || low >= 0xE000) {
+						throw ParsingError("bad string"s);
+					}
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				}
+				return code;
+			}
+
+			void ParseLiteral(std::string_view literal) {
+				if (static_cast<size_t>(end_ - pos_) < literal.size() || std::string_view(pos_, literal.size()) != literal) {
+					throw ParsingError("Parsing: literal error"s);
+				}
+				pos_ += literal.size();
+			}
+
+			bool IsDigit() const {
+				return pos_ != end_ && *pos_ >= '0' && *pos_ <= '9';
+			}
+
+			void SkipDigits() {
+				if (!IsDigit()) {
+					throw ParsingError("A digit is expected"s);
+				}
+				while (IsDigit()) {
+					++pos_;
+				}
+			}
+
+			Number ParseNumber() {
+				const char* begin = pos_;
+				if (pos_ != end_ && *pos_ == '-') {
+					++pos_;
+				}
+				if (pos_ != end_ && *pos_ == '0') {
+					++pos_;
+				}
+				else {
+					SkipDigits();
+				}
+
+				bool is_int = true;
+				if (pos_ != end_ && *pos_ == '.') {
+					++pos_;
+					SkipDigits();
+					is_int = false;
+				}
+				if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+					++pos_;
+					if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+						++pos_;
+					}
+					SkipDigits();
+					is_int = false;
+				}
+
+				// Integers that do not fit into int are read as double, and so is "-0",
+				// whose sign int cannot keep.
+				if (is_int) {
+					int value = 0;
+					if (const auto result = std::from_chars(begin, pos_, value); result.ec == std::errc{}) {
+						if (value == 0 && *begin == '-') {
+							return -0.0;
+						}
+						return value;
+					}
+				}
+
+				double value = 0.0;
+				if (const auto result = std::from_chars(begin, pos_, value); result.ec != std::errc{} || result.ptr != pos_) {
+					throw ParsingError("Failed to convert "s + string(begin, pos_) + " to number"s);
+				}
+				return value;
+			}
+
+			const char* begin_;
+			const char* pos_;
+			const char* end_;
+			string scratch_;
+		};
+
+		// The grammar of Parser::ParseEvents over a stream, read through a window of fixed
+		// size that is refilled as it is used up. Only the current string or number is
+		// kept whole, so memory does not depend on the length of the input.
+		class StreamParser {
+		public:
+			explicit StreamParser(std::istream& input)
+				: input_(input)
+				, window_(WINDOW_SIZE) {}
+
+			void ParseEvents(SaxHandler& handler) {
+				switch (SkipSpaces()) {
+				case EOF:
+					throw ParsingError("Unexpected end of input"s);
+				case '[':
+					++pos_;
+					handler.StartArray();
+					if (!TryConsume(']')) {
+						do {
+							ParseEvents(handler);
+						} while (Expect(",]"sv, "Parsing: Array error") == ',');
+					}
+					handler.EndArray();
+					break;
+				case '{':
+					++pos_;
+					handler.StartDict();
+					if (!TryConsume('}')) {
+						do {
+							Expect("\""sv, "Map parsing error");
+							handler.Key(ParseString());
+							Expect(":"sv, "Map parsing error");
+							ParseEvents(handler);
+						} while (Expect(",}"sv, "Map parsing error") == ',');
+					}
+					handler.EndDict();
+					break;
+				case '"':
+					++pos_;
+					handler.String(ParseString());
+					break;
+				case 't':
+					ParseLiteral("true"sv);
+					handler.Bool(true);
+					break;
+				case 'f':
+					ParseLiteral("false"sv);
+					handler.Bool(false);
+					break;
+				case 'n':
+					ParseLiteral("null"sv);
+					handler.Null();
+					break;
 				default:
-					input >> std::skipws;
-					throw json::ParsingError("bad string"s);
+					if (const Number number = ParseNumber(); std::holds_alternative<int>(number)) {
+						handler.Int(std::get<int>(number));
+					}
+					else {
+						handler.Double(std::get<double>(number));
+					}
 				}
 			}
-			else {
-				line.push_back(c);
+
+		private:
+			static constexpr size_t WINDOW_SIZE = 1 << 16;
+
+			// The next character without consuming it, EOF at the end of the stream.
+			int Peek() {
+				if (pos_ == end_ && !Refill()) {
+					return EOF;
+				}
+				return static_cast<unsigned char>(*pos_);
 			}
-		}
-		throw json::ParsingError("String parsing error"s);
-	}
 
-	Node LoadDict(istream& input) {
-		Dict result;
-		char c;
-		while (input >> c) {
-			if (c == '}') {
-				return Node(move(result));
+			char Get() {
+				if (Peek() == EOF) {
+					throw ParsingError("Unexpected end of input"s);
+				}
+				return *pos_++;
 			}
-			if (c == ',') {
-				input >> c;
+
+			bool Refill() {
+				if (!input_.rdbuf()) {
+					return false;
+				}
+				const streamsize count = input_.rdbuf()->sgetn(window_.data(), window_.size());
+				if (count <= 0) {
+					return false;
+				}
+				pos_ = window_.data();
+				end_ = pos_ + count;
+				return true;
 			}
-			string key = LoadString(input).AsString();
-			input >> c;
-			result.insert({ move(key), LoadNode(input) });
-		}
-		throw json::ParsingError("Map parsing error"s);
-	}
 
-	Node LoadBool(istream& input) {
-		string value(5, '\0');
+			int SkipSpaces() {
+				int c = Peek();
+				while (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+					++pos_;
+					c = Peek();
+				}
+				return c;
+			}
 
-		for (int i = 0; i < 4; ++i) {
-			input >> value[i];
-		}
+			char Expect(std::string_view expected, const char* error) {
+				const int c = SkipSpaces();
+				if (c == EOF || expected.find(static_cast<char>(c)) == std::string_view::npos) {
+					throw ParsingError(error);
+				}
+				return *pos_++;
+			}
 
-		if (value.substr(0, 4) == "true") {
-			return Node(true);
-		}
+			bool TryConsume(char c) {
+				if (SkipSpaces() == static_cast<unsigned char>(c)) {
+					++pos_;
+					return true;
+				}
+				return false;
+			}
 
-		input >> value[4];
-		if (value == "false") {
-			return Node(false);
-		}
+			// Called after the opening quote; the result is valid until the next call.
+			std::string_view ParseString() {
+				scratch_.clear();
+				while (true) {
+					if (Peek() == EOF) {
+						throw ParsingError("String parsing error"s);
+					}
+					const char* run = pos_;
+					while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\') {
+						++pos_;
+					}
+					scratch_.append(run, pos_);
+					if (pos_ == end_) {
+						continue;
+					}
+					if (*pos_++ == '"') {
+						return scratch_;
+					}
+					const char escaped = Get();
+					if (escaped == 'u') {
+						AppendUtf8(scratch_, ParseCodePoint());
+					}
+					else {
+						scratch_.push_back(Unescape(escaped));
+					}
+				}
+			}
 
-		throw json::ParsingError("Parsing: bool error"s);
-	}
+			static char Unescape(char c) {
+				switch (c) {
+				case '"': return '"';
+				case '\\': return '\\';
+				case '/': return '/';
+				case 'b': return '\b';
+				case 'f': return '\f';
+				case 'n': return '\n';
+				case 'r': return '\r';
+				case 't': return '\t';
+				default:
+					throw ParsingError("bad string"s);
+				}
+			}
 
-	Node LoadNull(istream& input) {
-		string value(4, '\0');
-		for (int i = 0; i < 4; ++i) {
-			input >> value[i];
-		}
+			uint32_t ParseHex4() {
+				uint32_t code = 0;
+				for (int i = 0; i < 4; ++i) {
+					const char c = Get();
+					code <<= 4;
+					if (c >= '0' && c <= '9') code |= c - '0';
+					else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+					else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+					else throw ParsingError("bad string"s);
+				}
+				return code;
+			}
 
-		if (value == "null") {
-			return Node(nullptr);
-		}
+			// A high surrogate not followed by an escape is kept as is, as Parser does.
+			uint32_t ParseCodePoint() {
+				uint32_t code = ParseHex4();
+				if (code < 0xD800 || code >= 0xDC00 || Peek() != '\\') {
+					return code;
+				}
+				++pos_;
+				const char escaped = Get();
+				if (escaped != 'u') {
+					AppendUtf8(scratch_, code);
+					return static_cast<unsigned char>(Unescape(escaped));
+				}
+				const uint32_t low = ParseHex4();
+				if (low < 0xDC00 || low >= 0xE000) {
+					throw ParsingError("bad string"s);
+				}
+				return 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+			}
 
-		throw json::ParsingError("Parsing: null error"s);
-	}
+			void ParseLiteral(std::string_view literal) {
+				for (const char c : literal) {
+					if (Peek() != static_cast<unsigned char>(c)) {
+						throw ParsingError("Parsing: literal error"s);
+					}
+					++pos_;
+				}
+			}
 
-	Node LoadNode(istream& input) {
-		char c;
-		input >> c;
+			// Collects the characters a number can have and leaves the grammar to Parser.
+			Number ParseNumber() {
+				scratch_.clear();
+				for (int c = Peek(); c != EOF && (std::isdigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'); c = Peek()) {
+					scratch_.push_back(static_cast<char>(c));
+					++pos_;
+				}
+				return Parser(scratch_).ParseWholeNumber();
+			}
+
+			std::istream& input_;
+			std::vector<char> window_;
+			const char* pos_ = nullptr;
+			const char* end_ = nullptr;
+			string scratch_;
+		};
 
-		if (c == '[') {
-			return LoadArray(input);
-		}
-		else if (c == '{') {
-			return LoadDict(input);
-		}
-		else if (c == '"') {
-			return LoadString(input);
-		}
-		else if (c == 't' || c == 'f') {
-			input.putback(c);
-			return LoadBool(input);
-		}
-		else if (c == 'n') {
-			input.putback(c);
-			return LoadNull(input);
-		}
-		else {
-			input.putback(c);
-			Number x = LoadNumber(input);
-			return (std::holds_alternative<int>(x) ? Node(std::get<int>(x)) : Node(std::get<double>(x)));
-		}
 	}
 
 	Node::Node(bool val)
@@ -308,6 +686,10 @@ namespace json {
 		return std::holds_alternative<Dict>(value_);
 	}
 
+	Data& Node::GetValue() {
+		return value_;
+	}
+
 	bool Node::operator==(const Node& other) const {
 		return value_ == other.value_;
 	}
@@ -323,29 +705,132 @@ namespace json {
 		return root_;
 	}
 
+	Document Load(std::string_view input) {
+		return Document{ Parser(input).ParseNode() };
+	}
+
 	Document Load(istream& input) {
-		return Document{ LoadNode(input) };
+		return Load(ReadAll(input));
+	}
+
+	string ReadAll(istream& input) {
+		string buffer;
+		array<char, 1 << 16> chunk;
+		while (input.rdbuf()) {
+			const streamsize count = input.rdbuf()->sgetn(chunk.data(), chunk.size());
+			if (count <= 0) {
+				break;
+			}
+			buffer.append(chunk.data(), static_cast<size_t>(count));
+		}
+		return buffer;
+	}
+
+	void Parse(std::string_view input, SaxHandler& handler) {
+		Parser(input).ParseEvents(handler);
+	}
+
+	void Parse(std::istream& input, SaxHandler& handler) {
+		StreamParser(input).ParseEvents(handler);
+	}
+
+	void ParseSequence(std::string_view input, SaxHandler& handler) {
+		Parser(input).ParseSequenceEvents(handler);
+	}
+
+	void NodeHandler::Null() {
+		AddValue(Node(nullptr));
+	}
+
+	void NodeHandler::Bool(bool value) {
+		AddValue(Node(value));
+	}
+
+	void NodeHandler::Int(int value) {
+		AddValue(Node(value));
+	}
+
+	void NodeHandler::Double(double value) {
+		AddValue(Node(value));
+	}
+
+	void NodeHandler::String(std::string_view value) {
+		AddValue(Node(string(value)));
+	}
+
+	void NodeHandler::Key(std::string_view key) {
+		if (stack_.empty() || !stack_.back().is_dict) {
+			throw ParsingError("Key outside of a dict"s);
+		}
+		stack_.back().key = key;
+	}
+
+	void NodeHandler::StartArray() {
+		stack_.push_back(Frame{});
+	}
+
+	void NodeHandler::EndArray() {
+		Array array = move(stack_.back().array);
+		stack_.pop_back();
+		AddValue(Node(move(array)));
+	}
+
+	void NodeHandler::StartDict() {
+		stack_.emplace_back().is_dict = true;
+	}
+
+	void NodeHandler::EndDict() {
+		Dict dict = move(stack_.back().dict);
+		stack_.pop_back();
+		AddValue(Node(move(dict)));
+	}
+
+	bool NodeHandler::IsComplete() const {
+		return root_.has_value();
+	}
+
+	Node NodeHandler::Extract() {
+		Node result = move(*root_);
+		root_.reset();
+		return result;
+	}
+
+	void NodeHandler::AddValue(Node value) {
+		if (stack_.empty()) {
+			root_ = move(value);
+		}
+		else if (stack_.back().is_dict) {
+			stack_.back().dict.insert({ move(stack_.back().key), move(value) });
+		}
+		else {
+			stack_.back().array.push_back(move(value));
+		}
 	}
 
 	void Node::Print(std::ostream& out) const {
+		io::Sink sink(out);
+		Print(sink);
+	}
+
+	void Node::Print(io::Sink& out) const {
 		std::visit(Printer{ out }, value_);
 	}
 
 	void Node::Printer::operator()(std::nullptr_t) const {
-		output << "null"s;
+		output << "null"sv;
 	}
 
 	void Node::Printer::operator()(const Array& value) const {
-		output << "["s;
+		output << '[';
 		bool first = true;
 		for (auto it = value.begin(); it != value.end(); ++it) {
 			if (!first) {
-				output << ", ";
+				output << ", "sv;
 			}
 			first = false;
 			(*it).Print(output);
 		}
-		output << "]"s;
+		output << ']';
 	}
 
 	void Node::Printer::operator()(const Dict& value) const {
@@ -353,62 +838,44 @@ namespace json {
 		bool first = true;
 		for (const auto& [key, node] : value) {
 			if (!first) {
-				output << ", ";
+				output << ", "sv;
 			}
 			first = false;
 			Printer{ output }(key);
-			output << ": ";
+			output << ": "sv;
 			node.Print(output);
 		}
 		output << '}';
 	}
 
 	void Node::Printer::operator()(const bool value) const {
-		if (value) {
-			output << "true"s;
-		}
-		else {
-			output << "false"s;
-		}
+		output << (value ? "true"sv : "false"sv);
 	}
 
 	void Node::Printer::operator()(const int value) const {
 		output << value;
 	}
 
+	// The shortest text that reads back as exactly the same double.
 	void Node::Printer::operator()(const double value) const {
-		output << value;
+		output.WriteRoundTrip(value);
 	}
 
 	void Node::Printer::operator()(const std::string_view value) const {
-		string result = "\""s;
-		for (const char c : value) {
-			switch (c) {
-			case '\\':
-				result += "\\\\"s;
-				break;
-			case '\"':
-				result += "\\\""s;
-				break;
-			case '\n':
-				result += "\\n"s;
-				break;
-			case '\r':
-				result += "\\r"s;
-				break;
-			case '\t':
-				result += "\\t"s;
-				break;
-			default:
-				result += c;
-			}
-		}
-		output << result + "\""s;
+		output << '"';
+		WriteEscaped(value, [this](std::string_view piece) {
+			output << piece;
+		});
+		output << '"';
 	}
 
 	void Print(const Document& doc, std::ostream& output) {
 		doc.GetRoot().Print(output);
 	}
 
+	void Print(const Document& doc, io::Sink& output) {
+		doc.GetRoot().Print(output);
+	}
+
 
 }
\ No newline at end of file
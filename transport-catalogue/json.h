@@ -1,8 +1,12 @@
 #pragma once
 
+#include "output_sink.h"
+
 #include <iostream>
 #include <map>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <initializer_list>
 #include <vector>
 #include <variant>
@@ -12,6 +16,7 @@ namespace json {
 	class Node;
 	using Dict = std::map<std::string, Node>;
 	using Array = std::vector<Node>;
+
 	using Data = std::variant<std::nullptr_t, Array, Dict, int, double, bool, std::string >;
 
 	class ParsingError : public std::runtime_error {
@@ -50,12 +55,16 @@ namespace json {
 		bool operator!=(const Node& other) const;
 
 		void Print(std::ostream& out) const;
+		void Print(io::Sink& out) const;
+
+		// Mutable access for builders that fill a node in place.
+		Data& GetValue();
 
 	private:
 		Data value_;
 
 		struct Printer {
-			std::ostream& output;
+			io::Sink& output;
 
 			void operator()(std::nullptr_t) const;
 			void operator()(const Array& value) const;
@@ -84,7 +93,72 @@ namespace json {
 		Node root_;
 	};
 
+	Document Load(std::string_view input);
 	Document Load(std::istream& input);
 
+	// Reads the rest of the stream into one buffer.
+	std::string ReadAll(std::istream& input);
+
+	// Receives parse events in document order. Views passed to String and Key
+	// are only valid for the duration of the call.
+	class SaxHandler {
+	public:
+		virtual ~SaxHandler() = default;
+
+		virtual void Null() = 0;
+		virtual void Bool(bool value) = 0;
+		virtual void Int(int value) = 0;
+		virtual void Double(double value) = 0;
+		virtual void String(std::string_view value) = 0;
+		virtual void Key(std::string_view key) = 0;
+		virtual void StartArray() = 0;
+		virtual void EndArray() = 0;
+		virtual void StartDict() = 0;
+		virtual void EndDict() = 0;
+	};
+
+	// Parses one value from input and reports it to handler without building nodes.
+	void Parse(std::string_view input, SaxHandler& handler);
+	// The same for a stream that is read through a fixed-size window, so that memory stays
+	// the same however long the input is.
+	void Parse(std::istream& input, SaxHandler& handler);
+
+	// Parses the comma-separated values of an array without its brackets, such as a
+	// run of its elements cut out of the document, and reports each of them to handler.
+	void ParseSequence(std::string_view input, SaxHandler& handler);
+
+	// Collects the events of a single value back into a Node, for the parts of
+	// a streamed document that are small enough to keep whole.
+	class NodeHandler final : public SaxHandler {
+	public:
+		void Null() override;
+		void Bool(bool value) override;
+		void Int(int value) override;
+		void Double(double value) override;
+		void String(std::string_view value) override;
+		void Key(std::string_view key) override;
+		void StartArray() override;
+		void EndArray() override;
+		void StartDict() override;
+		void EndDict() override;
+
+		bool IsComplete() const;
+		Node Extract();
+
+	private:
+		struct Frame {
+			bool is_dict = false;
+			Array array;
+			Dict dict;
+			std::string key;
+		};
+
+		void AddValue(Node value);
+
+		std::vector<Frame> stack_;
+		std::optional<Node> root_;
+	};
+
 	void Print(const Document& doc, std::ostream& output);
+	void Print(const Document& doc, io::Sink& output);
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "json.h"
+#include "json_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Measures the throughput of the JSON parsing stages in GB/s on generated inputs:
+//     json_bench [megabytes]
+namespace {
+
+	// A make_base input: short names, many numbers, about five bytes per token.
+	string MakeBaseInput(size_t size) {
+		mt19937 random(42);
+		uniform_real_distribution<double> coordinate(55.5, 55.9);
+		uniform_int_distribution<int> distance(100, 5000);
+		uniform_int_distribution<int> stop_pick(0, 9999);
+
+		string input = "{\"base_requests\": ["s;
+		for (int i = 0; input.size() < size; ++i) {
+			if (i > 0) {
+				input += ", "s;
+			}
+			if (i % 4 != 3) {
+				input += "{\"type\": \"Stop\", \"name\": \"Stop "s + to_string(i) + "\", \"latitude\": "s + to_string(coordinate(random))
+					+ ", \"longitude\": "s + to_string(coordinate(random)) + ", \"road_distances\": {"s;
+				for (int j = 0; j < 3; ++j) {
+					input += (j > 0 ? ", \"Stop "s : "\"Stop "s) + to_string(stop_pick(random)) + "\": "s + to_string(distance(random));
+				}
+				input += "}}"s;
+			}
+			else {
+				input += "{\"type\": \"Bus\", \"name\": \"Bus "s + to_string(i) + "\", \"is_roundtrip\": false, \"stops\": ["s;
+				for (int j = 0; j < 10; ++j) {
+					input += (j > 0 ? ", \"Stop "s : "\"Stop "s) + to_string(stop_pick(random)) + "\""s;
+				}
+				input += "]}"s;
+			}
+		}
+		input += "]}"s;
+		return input;
+	}
+
+	// Long strings with few tokens, such as stored maps.
+	string MakeStringInput(size_t size) {
+		const string line = "<polyline points=\\\"20,100.5 30.25,80 40,60\\\" fill=\\\"none\\\" stroke=\\\"green\\\"/>\\n"s;
+		string input = "["s;
+		while (input.size() < size) {
+			if (input.size() > 1) {
+				input += ", "s;
+			}
+			input += "{\"id\": 1, \"map\": \""s;
+			for (int i = 0; i < 200; ++i) {
+				input += line;
+			}
+			input += "\"}"s;
+		}
+		input += "]"s;
+		return input;
+	}
+
+	class CountingHandler final : public json::SaxHandler {
+	public:
+		void Null() override { ++events; }
+		void Bool(bool) override { ++events; }
+		void Int(int) override { ++events; }
+		void Double(double) override { ++events; }
+		void String(std::string_view) override { ++events; }
+		void Key(std::string_view) override { ++events; }
+		void StartArray() override { ++events; }
+		void EndArray() override { ++events; }
+		void StartDict() override { ++events; }
+		void EndDict() override { ++events; }
+
+		size_t events = 0;
+	};
+
+	// The best of a few runs.
+	double Measure(size_t bytes, const function<void()>& run) {
+		double best = 0.0;
+		for (int i = 0; i < 3; ++i) {
+			const auto start = chrono::steady_clock::now();
+			run();
+			const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+			best = max(best, bytes / elapsed.count() / 1e9);
+		}
+		return best;
+	}
+
+	void PrintRate(string_view stage, double rate) {
+		cout << "  "sv << left << setw(18) << stage << fixed << setprecision(2) << rate << " GB/s"sv << endl;
+	}
+
+	void Report(string_view name, const string& input) {
+		cout << name << ": "sv << input.size() / (1 << 20) << " MiB"sv << endl;
+
+		for (const string_view implementation : json::StructuralIndex::Implementations()) {
+			PrintRate("index ("s + string(implementation) + ")"s, Measure(input.size(), [&input, implementation] {
+				json::StructuralIndex index(input, implementation);
+				uint32_t position = 0;
+				while (index.Next(position)) {
+				}
+			}));
+		}
+		PrintRate("parse (events)"sv, Measure(input.size(), [&input] {
+			CountingHandler handler;
+			json::Parse(input, handler);
+		}));
+		PrintRate("load (nodes)"sv, Measure(input.size(), [&input] {
+			json::Load(input);
+		}));
+	}
+
+}
+
+int main(int argc, const char* argv[]) {
+	const size_t megabytes = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 64;
+	const size_t size = megabytes << 20;
+
+	Report("base_requests"sv, MakeBaseInput(size));
+	Report("long strings"sv, MakeStringInput(size));
+	return 0;
+}
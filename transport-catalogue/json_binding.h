@@ -0,0 +1,205 @@
+#pragma once
+
+#include "bits.h"
+#include "json.h"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Declares once, at compile time, which JSON keys of an object go into which members
+// of a struct. Reading walks the object once and dispatches every key through a
+// perfect hash of the declared keys straight into its member.
+namespace json::binding {
+
+	// FNV-1a with a seed; the same function is evaluated at compile time and at run time.
+	constexpr uint32_t HashKey(std::string_view key, uint32_t seed) {
+		uint32_t hash = 2166136261u ^ seed;
+		for (const char c : key) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 16777619u;
+		}
+		return hash ^ (hash >> 15);
+	}
+
+	// A collision-free hash of a fixed key set. The seed is searched for while the
+	// schema is compiled, so a lookup is one hash, one table read and one comparison.
+	template <size_t N>
+	class PerfectHash {
+	public:
+		static_assert(N > 0 && N <= 64, "a schema has from 1 to 64 fields");
+
+		constexpr explicit PerfectHash(const std::array<std::string_view, N>& keys)
+			: keys_(keys)
+		{
+			for (uint32_t seed = 0; seed < MAX_SEED; ++seed) {
+				if (TryBuild(seed)) {
+					seed_ = seed;
+					return;
+				}
+			}
+			throw std::logic_error("no perfect hash for the keys");
+		}
+
+		// Index of key among the keys, N when it is not one of them.
+		constexpr size_t Find(std::string_view key) const {
+			const uint8_t index = slots_[HashKey(key, seed_) & (TABLE_SIZE - 1)];
+			return index != EMPTY && keys_[index] == key ? index : N;
+		}
+
+		constexpr std::string_view Key(size_t index) const {
+			return keys_[index];
+		}
+
+	private:
+		static constexpr size_t TableSize() {
+			size_t size = 8;
+			while (size < N * 4) {
+				size *= 2;
+			}
+			return size;
+		}
+
+		static constexpr size_t TABLE_SIZE = TableSize();
+		static constexpr uint32_t MAX_SEED = 1 << 16;
+		static constexpr uint8_t EMPTY = 0xFF;
+
+		constexpr bool TryBuild(uint32_t seed) {
+			for (size_t slot = 0; slot < TABLE_SIZE; ++slot) {
+				slots_[slot] = EMPTY;
+			}
+			for (size_t index = 0; index < N; ++index) {
+				uint8_t& slot = slots_[HashKey(keys_[index], seed) & (TABLE_SIZE - 1)];
+				if (slot != EMPTY) {
+					return false;
+				}
+				slot = static_cast<uint8_t>(index);
+			}
+			return true;
+		}
+
+		std::array<std::string_view, N> keys_;
+		std::array<uint8_t, TABLE_SIZE> slots_{};
+		uint32_t seed_ = 0;
+	};
+
+	// Converts a value with the As* accessor that matches the member type.
+	struct ReadValue {
+		template <typename Member, typename NodeType>
+		void operator()(Member& target, const NodeType& node) const {
+			if constexpr (std::is_same_v<Member, bool>) {
+				target = node.AsBool();
+			}
+			else if constexpr (std::is_same_v<Member, int>) {
+				target = node.AsInt();
+			}
+			else if constexpr (std::is_same_v<Member, double>) {
+				target = node.AsDouble();
+			}
+			else {
+				static_assert(std::is_same_v<Member, std::string>, "the member needs its own reader");
+				target.assign(node.AsString());
+			}
+		}
+	};
+
+	// One key of an object and the member it is read into. read is called as
+	// read(member, node) or, when it takes them, read(member, node, context...).
+	template <typename Struct, typename Member, typename Read>
+	struct Field {
+		std::string_view key;
+		Member Struct::* member;
+		Read read;
+		bool required;
+	};
+
+	template <typename Struct, typename Member, typename Read = ReadValue>
+	constexpr Field<Struct, Member, Read> Required(std::string_view key, Member Struct::* member, Read read = {}) {
+		return { key, member, read, true };
+	}
+
+	template <typename Struct, typename Member, typename Read = ReadValue>
+	constexpr Field<Struct, Member, Read> Optional(std::string_view key, Member Struct::* member, Read read = {}) {
+		return { key, member, read, false };
+	}
+
+	template <typename Struct, typename... Fields>
+	class Schema {
+	public:
+		constexpr explicit Schema(Fields... fields)
+			: fields_(fields...)
+			, hash_(std::array<std::string_view, COUNT>{ fields.key... })
+			, required_(RequiredMask(fields...)) {}
+
+		// The bit of key in the masks Read returns.
+		constexpr uint64_t Bit(std::string_view key) const {
+			const size_t index = hash_.Find(key);
+			if (index == COUNT) {
+				throw std::logic_error("unknown field");
+			}
+			return uint64_t{ 1 } << index;
+		}
+
+		// Reads the declared keys of dict into target, ignoring the others, and returns
+		// the mask of the keys that were present. Throws if a required key is missing.
+		template <typename DictType, typename... Context>
+		uint64_t Read(const DictType& dict, Struct& target, Context&... context) const {
+			uint64_t seen = 0;
+			for (const auto& [key, value] : dict) {
+				const size_t index = hash_.Find(key);
+				if (index == COUNT) {
+					continue;
+				}
+				ReadField(index, target, value, std::index_sequence_for<Fields...>{}, context...);
+				seen |= uint64_t{ 1 } << index;
+			}
+
+			if (const uint64_t missing = required_ & ~seen; missing != 0) {
+				throw ParsingError("missing key " + std::string(hash_.Key(bits::CountTrailingZeros(missing))));
+			}
+			return seen;
+		}
+
+	private:
+		static constexpr size_t COUNT = sizeof...(Fields);
+
+		static constexpr uint64_t RequiredMask(const Fields&... fields) {
+			uint64_t mask = 0;
+			size_t index = 0;
+			((mask |= fields.required ? uint64_t{ 1 } << index : 0, ++index), ...);
+			return mask;
+		}
+
+		// Compares index with each field number in turn, which the compiler folds into a switch.
+		template <typename NodeType, size_t... Index, typename... Context>
+		void ReadField(size_t index, Struct& target, const NodeType& value, std::index_sequence<Index...>, Context&... context) const {
+			((index == Index && (Apply(std::get<Index>(fields_), target, value, context...), true)) || ...);
+		}
+
+		template <typename FieldType, typename NodeType, typename... Context>
+		static void Apply(const FieldType& field, Struct& target, const NodeType& value, Context&... context) {
+			auto& member = target.*field.member;
+			if constexpr (std::is_invocable_v<decltype(field.read), decltype(member), const NodeType&, Context&...>) {
+				field.read(member, value, context...);
+			}
+			else {
+				field.read(member, value);
+			}
+		}
+
+		std::tuple<Fields...> fields_;
+		PerfectHash<COUNT> hash_;
+		uint64_t required_;
+	};
+
+	template <typename Struct, typename... Fields>
+	constexpr Schema<Struct, Fields...> MakeSchema(Fields... fields) {
+		return Schema<Struct, Fields...>(fields...);
+	}
+
+}
@@ -19,21 +19,23 @@ namespace json {
 
     Node Builder::Build() {
         if (state_ == state::FINISH) {
-            return *steps_.top();
+            Node result = std::move(*steps_.top());
+            Clear();
+            return result;
         }
         else {
             throw std::logic_error("building of unready node");
         }
     }
 
-    ValueBuilder Builder::Key(const std::string& key) {
+    ValueBuilder Builder::Key(std::string key) {
         switch (state_) {
         case state::START:
             throw std::logic_error("empty node key add attempt");
             break;
         case state::CHANGE: {
             if (steps_.top().get()->IsMap()) {
-                steps_.push(std::make_unique<Node>(key));
+                steps_.push(std::make_unique<Node>(std::move(key)));
             }
             else {
                 throw std::logic_error(IsDictKeyTop() ? "dict key entered twice" : "not dict node key add attempt");
@@ -96,35 +98,28 @@ namespace json {
     }
 
     Builder& Builder::Value(const Data& value) {
+        return Value(Data(value));
+    }
+
+    Builder& Builder::Value(Data&& value) {
+        Node node = std::visit([](auto&& value) {
+            return Node(std::move(value));
+            }, std::move(value));
+
         switch (state_) {
         case state::START: {
-            steps_.push(std::make_unique<Node>(
-                std::visit([](auto& value) {
-                    return Node(value);
-                    }, value)
-                )
-            );
+            steps_.push(std::make_unique<Node>(std::move(node)));
             state_ = state::FINISH;
         }
                          break;
         case state::CHANGE: {
             if (steps_.top()->IsArray()) {
-                json::Array tmp = std::move(steps_.top()->AsArray());
-                tmp.emplace_back(
-                    std::visit([](auto& value) {
-                        return Node(value);
-                        }, value)
-                );
-                *steps_.top() = Node(std::move(tmp));
+                std::get<Array>(steps_.top()->GetValue()).push_back(std::move(node));
             }
             else if (IsDictKeyTop()) {
-                std::string key = std::move(steps_.top()->AsString());
+                std::string key = std::move(std::get<std::string>(steps_.top()->GetValue()));
                 steps_.pop();
-                json::Dict dict = std::move(steps_.top().get()->AsMap());
-                dict.insert({ key, std::visit([](auto& value) {
-                    return Node(value);
-                    }, value) });
-                *steps_.top() = Node(std::move(dict));
+                std::get<Dict>(steps_.top()->GetValue()).insert({ std::move(key), std::move(node) });
             }
             else {
                 throw std::logic_error("dict value without key add attempt");
@@ -150,9 +145,9 @@ namespace json {
                     state_ = state::FINISH;
                 }
                 else {
-                    json::Dict value = std::move(steps_.top().get()->AsMap());
+                    json::Dict value = std::move(std::get<Dict>(steps_.top()->GetValue()));
                     steps_.pop();
-                    Value(value);
+                    Value(std::move(value));
                 }
             }
             else {
@@ -179,9 +174,9 @@ namespace json {
                     state_ = state::FINISH;
                 }
                 else {
-                    json::Array value = std::move(steps_.top()->AsArray());
+                    json::Array value = std::move(std::get<Array>(steps_.top()->GetValue()));
                     steps_.pop();
-                    Value(value);
+                    Value(std::move(value));
                 }
             }
             else {
@@ -202,6 +197,10 @@ namespace json {
         return ArrayBuilder(builder_.Value(value));
     }
 
+    ArrayBuilder ArrayBuilder::Value(Data&& value) {
+        return ArrayBuilder(builder_.Value(std::move(value)));
+    }
+
     DictBuilder ArrayBuilder::StartDict() {
         return builder_.StartDict();
     }
@@ -215,8 +214,8 @@ namespace json {
     }
 
 
-    ValueBuilder DictBuilder::Key(const std::string& key) {
-        return builder_.Key(key);
+    ValueBuilder DictBuilder::Key(std::string key) {
+        return builder_.Key(std::move(key));
     }
 
     Builder& DictBuilder::EndDict() {
@@ -228,6 +227,10 @@ namespace json {
         return DictBuilder(builder_.Value(value));
     }
 
+    DictBuilder ValueBuilder::Value(Data&& value) {
+        return DictBuilder(builder_.Value(std::move(value)));
+    }
+
     DictBuilder ValueBuilder::StartDict() {
         return builder_.StartDict();
     }
@@ -18,15 +18,17 @@ namespace json {
 		Builder() = default;
 		~Builder();
 
-		ValueBuilder Key(const std::string& key);
+		ValueBuilder Key(std::string key);
 		DictBuilder StartDict();
 		ArrayBuilder StartArray();
 
 		Builder& Value(const Data& value);
+		Builder& Value(Data&& value);
 		Builder& EndDict();
 		Builder& EndArray();
 
 		void Clear();
+		// Moves the finished node out and leaves the builder empty.
 		Node Build();
 		bool IsDictKeyTop();
 
@@ -45,6 +47,7 @@ namespace json {
 		}
 
 		ArrayBuilder Value(const Data& value);
+		ArrayBuilder Value(Data&& value);
 
 		DictBuilder StartDict();
 
@@ -64,7 +67,7 @@ namespace json {
 
 		}
 
-		ValueBuilder Key(const std::string& key);
+		ValueBuilder Key(std::string key);
 
 		Builder& EndDict();
 
@@ -82,6 +85,7 @@ namespace json {
 		}
 
 		DictBuilder Value(const Data& value);
+		DictBuilder Value(Data&& value);
 
 		DictBuilder StartDict();
 
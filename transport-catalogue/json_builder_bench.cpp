@@ -0,0 +1,89 @@
+#include "json.h"
+#include "json_builder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Builds Map responses with json::Builder, once copying the map string in and once
+// moving it, and reports the time per response:
+//     json_builder_bench [kilobytes]
+namespace {
+
+	string MakeMap(size_t size) {
+		const string line = "<polyline points=\"20,100.5 30.25,80 40,60\" fill=\"none\" stroke=\"green\"/>\n"s;
+		string map = "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"s;
+		while (map.size() < size) {
+			map += line;
+		}
+		return map;
+	}
+
+	json::Node BuildResponse(int id, json::Data map) {
+		return json::Builder{}
+			.StartDict()
+				.Key("map"s).Value(std::move(map))
+				.Key("request_id"s).Value(id)
+			.EndDict()
+			.Build();
+	}
+
+	// Takes the map string back out of a built response without copying it.
+	string TakeMap(json::Node& response) {
+		json::Dict& dict = get<json::Dict>(response.GetValue());
+		return std::move(get<string>(dict.at("map"s).GetValue()));
+	}
+
+	// The best of a few runs, in microseconds per response.
+	double Measure(int count, const function<void()>& run) {
+		double best = 0.0;
+		for (int i = 0; i < 3; ++i) {
+			const auto start = chrono::steady_clock::now();
+			run();
+			const chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+			best = i == 0 ? elapsed.count() / count : min(best, elapsed.count() / count);
+		}
+		return best;
+	}
+
+	void PrintTime(string_view variant, double time) {
+		cout << "  "sv << left << setw(8) << variant << fixed << setprecision(2) << time << " us/response"sv << endl;
+	}
+
+}
+
+int main(int argc, const char* argv[]) {
+	const size_t kilobytes = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 1024;
+	const int count = 200;
+	string map = MakeMap(kilobytes << 10);
+	cout << "Map response: "sv << map.size() / 1024 << " KiB"sv << endl;
+
+	PrintTime("copy"sv, Measure(count, [&map] {
+		for (int id = 0; id < count; ++id) {
+			json::Node response = BuildResponse(id, map);
+			if (response.AsMap().at("map"s).AsString().size() != map.size()) {
+				abort();
+			}
+		}
+	}));
+
+	// The same buffer goes into every response and comes back out of it.
+	const char* const buffer = map.data();
+	bool copied = false;
+	PrintTime("move"sv, Measure(count, [&map, &copied, buffer] {
+		for (int id = 0; id < count; ++id) {
+			json::Node response = BuildResponse(id, std::move(map));
+			map = TakeMap(response);
+			copied = copied || map.data() != buffer;
+		}
+	}));
+	cout << "  map string copied when moved: "sv << (copied ? "yes"sv : "no"sv) << endl;
+	return copied ? 1 : 0;
+}
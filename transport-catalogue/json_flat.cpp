@@ -0,0 +1,270 @@
+#include "json_flat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace json::flat {
+
+	using namespace std::literals;
+
+	void* Arena::Allocate(size_t size, size_t align) {
+		size_t padding = (align - reinterpret_cast<uintptr_t>(pos_) % align) % align;
+		if (!pos_ || padding + size > left_) {
+			const size_t block_size = std::max(next_block_size_, size + align);
+			blocks_.push_back(std::make_unique<char[]>(block_size));
+			pos_ = blocks_.back().get();
+			left_ = block_size;
+			next_block_size_ = std::min(next_block_size_ * 2, MAX_BLOCK_SIZE);
+			padding = (align - reinterpret_cast<uintptr_t>(pos_) % align) % align;
+		}
+		char* result = pos_ + padding;
+		pos_ = result + size;
+		left_ -= padding + size;
+		return result;
+	}
+
+	const Member* Dict::find(std::string_view key) const {
+		const Member* it = std::lower_bound(begin(), end(), key, [](const Member& member, std::string_view key) {
+			return member.first < key;
+			});
+		return it != end() && it->first == key ? it : end();
+	}
+
+	const Node& Dict::at(std::string_view key) const {
+		const Member* it = find(key);
+		if (it == end()) {
+			throw std::out_of_range("no such key: "s + std::string(key));
+		}
+		return it->second;
+	}
+
+	bool Node::AsBool() const {
+		if (IsBool()) {
+			return bool_;
+		}
+		throw std::logic_error("Failed: return not bool"s);
+	}
+
+	int Node::AsInt() const {
+		if (IsInt()) {
+			return int_;
+		}
+		throw std::logic_error("Failed: return not int"s);
+	}
+
+	double Node::AsDouble() const {
+		if (IsPureDouble()) {
+			return double_;
+		}
+		if (IsInt()) {
+			return int_;
+		}
+		throw std::logic_error("Failed: return not double"s);
+	}
+
+	std::string_view Node::AsString() const {
+		if (IsString()) {
+			return std::string_view(chars_, size_);
+		}
+		throw std::logic_error("Failed: return not string"s);
+	}
+
+	Array Node::AsArray() const {
+		if (IsArray()) {
+			return Array(items_, size_);
+		}
+		throw std::logic_error("Failed: return not array"s);
+	}
+
+	Dict Node::AsMap() const {
+		if (IsMap()) {
+			return Dict(members_, size_);
+		}
+		throw std::logic_error("Failed: return not Dict"s);
+	}
+
+	bool Node::IsNull() const {
+		return type_ == Type::NUL;
+	}
+
+	bool Node::IsBool() const {
+		return type_ == Type::BOOL;
+	}
+
+	bool Node::IsInt() const {
+		return type_ == Type::INT;
+	}
+
+	bool Node::IsDouble() const {
+		return IsPureDouble() || IsInt();
+	}
+
+	bool Node::IsPureDouble() const {
+		return type_ == Type::DOUBLE;
+	}
+
+	bool Node::IsString() const {
+		return type_ == Type::STRING;
+	}
+
+	bool Node::IsArray() const {
+		return type_ == Type::ARRAY;
+	}
+
+	bool Node::IsMap() const {
+		return type_ == Type::DICT;
+	}
+
+	// Collects parse events on two scratch stacks and copies each finished container
+	// into the arena in one piece.
+	class Loader final : public SaxHandler {
+	public:
+		Loader(std::string_view input, Arena& arena)
+			: input_(input)
+			, arena_(arena) {}
+
+		void Null() override {
+			AddValue(Node{});
+		}
+
+		void Bool(bool value) override {
+			Node node;
+			node.type_ = Node::Type::BOOL;
+			node.bool_ = value;
+			AddValue(node);
+		}
+
+		void Int(int value) override {
+			Node node;
+			node.type_ = Node::Type::INT;
+			node.int_ = value;
+			AddValue(node);
+		}
+
+		void Double(double value) override {
+			Node node;
+			node.type_ = Node::Type::DOUBLE;
+			node.double_ = value;
+			AddValue(node);
+		}
+
+		void String(std::string_view value) override {
+			value = Keep(value);
+			Node node;
+			node.type_ = Node::Type::STRING;
+			node.size_ = static_cast<uint32_t>(value.size());
+			node.chars_ = value.data();
+			AddValue(node);
+		}
+
+		void Key(std::string_view key) override {
+			key_ = Keep(key);
+		}
+
+		void StartArray() override {
+			frames_.push_back({ false, items_.size(), key_ });
+		}
+
+		void EndArray() override {
+			const size_t first = frames_.back().first;
+			key_ = frames_.back().key;
+			frames_.pop_back();
+
+			const size_t size = items_.size() - first;
+			Node* items = arena_.AllocateArray<Node>(size);
+			std::copy(items_.begin() + first, items_.end(), items);
+			items_.resize(first);
+
+			Node node;
+			node.type_ = Node::Type::ARRAY;
+			node.size_ = static_cast<uint32_t>(size);
+			node.items_ = items;
+			AddValue(node);
+		}
+
+		void StartDict() override {
+			frames_.push_back({ true, members_.size(), key_ });
+		}
+
+		// Like std::map::insert, the first of duplicate keys wins.
+		void EndDict() override {
+			const size_t first = frames_.back().first;
+			key_ = frames_.back().key;
+			frames_.pop_back();
+
+			const auto begin = members_.begin() + first;
+			std::stable_sort(begin, members_.end(), [](const Member& lhs, const Member& rhs) {
+				return lhs.first < rhs.first;
+				});
+			const auto end = std::unique(begin, members_.end(), [](const Member& lhs, const Member& rhs) {
+				return lhs.first == rhs.first;
+				});
+
+			const size_t size = end - begin;
+			Member* members = arena_.AllocateArray<Member>(size);
+			std::copy(begin, end, members);
+			members_.resize(first);
+
+			Node node;
+			node.type_ = Node::Type::DICT;
+			node.size_ = static_cast<uint32_t>(size);
+			node.members_ = members;
+			AddValue(node);
+		}
+
+		Node GetRoot() const {
+			return root_;
+		}
+
+	private:
+		// key is the one the container itself is stored under in its parent dict.
+		struct Frame {
+			bool is_dict;
+			size_t first;
+			std::string_view key;
+		};
+
+		// Views into the input are kept as they are; unescaped copies are moved to the arena.
+		std::string_view Keep(std::string_view value) {
+			if (value.data() >= input_.data() && value.data() + value.size() <= input_.data() + input_.size()) {
+				return value;
+			}
+			char* chars = arena_.AllocateArray<char>(value.size());
+			std::memcpy(chars, value.data(), value.size());
+			return std::string_view(chars, value.size());
+		}
+
+		void AddValue(const Node& node) {
+			if (frames_.empty()) {
+				root_ = node;
+			}
+			else if (frames_.back().is_dict) {
+				members_.push_back({ key_, node });
+			}
+			else {
+				items_.push_back(node);
+			}
+		}
+
+		std::string_view input_;
+		Arena& arena_;
+
+		std::vector<Frame> frames_;
+		std::vector<Node> items_;
+		std::vector<Member> members_;
+		std::string_view key_;
+		Node root_;
+	};
+
+	Document::Document(std::string_view input) {
+		Loader loader(input, arena_);
+		Parse(input, loader);
+		root_ = loader.GetRoot();
+	}
+
+	const Node& Document::GetRoot() const {
+		return root_;
+	}
+
+}
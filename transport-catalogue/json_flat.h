@@ -0,0 +1,130 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json::flat {
+
+	// Bump allocator: memory is handed out from a few growing blocks and released
+	// all at once with the arena.
+	class Arena {
+	public:
+		void* Allocate(size_t size, size_t align);
+
+		template <typename T>
+		T* AllocateArray(size_t count) {
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+	private:
+		static constexpr size_t FIRST_BLOCK_SIZE = 4096;
+		static constexpr size_t MAX_BLOCK_SIZE = 1 << 20;
+
+		std::vector<std::unique_ptr<char[]>> blocks_;
+		char* pos_ = nullptr;
+		size_t left_ = 0;
+		size_t next_block_size_ = FIRST_BLOCK_SIZE;
+	};
+
+	class Node;
+	using Member = std::pair<std::string_view, Node>;
+
+	template <typename T>
+	class Range {
+	public:
+		Range() = default;
+		Range(const T* begin, size_t size)
+			: begin_(begin)
+			, size_(size) {}
+
+		const T* begin() const {
+			return begin_;
+		}
+		const T* end() const {
+			return begin_ + size_;
+		}
+		size_t size() const {
+			return size_;
+		}
+		bool empty() const {
+			return size_ == 0;
+		}
+		const T& operator[](size_t index) const {
+			return begin_[index];
+		}
+
+	private:
+		const T* begin_ = nullptr;
+		size_t size_ = 0;
+	};
+
+	using Array = Range<Node>;
+
+	// Members sorted by key, so lookups are binary searches. Mirrors the parts of
+	// std::map that readers use.
+	class Dict : public Range<Member> {
+	public:
+		using Range::Range;
+
+		const Member* find(std::string_view key) const;
+		const Node& at(std::string_view key) const;
+	};
+
+	// A trivially copyable view of a parsed value; everything it points to lives in
+	// the arena of its Document or in the input buffer.
+	class Node {
+	public:
+		Node() = default;
+
+		bool AsBool() const;
+		int AsInt() const;
+		double AsDouble() const;
+		std::string_view AsString() const;
+		Array AsArray() const;
+		Dict AsMap() const;
+
+		bool IsNull() const;
+		bool IsBool() const;
+		bool IsInt() const;
+		bool IsDouble() const;
+		bool IsPureDouble() const;
+		bool IsString() const;
+		bool IsArray() const;
+		bool IsMap() const;
+
+	private:
+		friend class Loader;
+
+		enum class Type : uint8_t { NUL, BOOL, INT, DOUBLE, STRING, ARRAY, DICT };
+
+		Type type_ = Type::NUL;
+		uint32_t size_ = 0;
+		union {
+			bool bool_;
+			int int_;
+			double double_;
+			const char* chars_;
+			const Node* items_;
+			const Member* members_;
+		};
+	};
+
+	// Owns every node of a parsed input. Strings without escapes are views into the
+	// input, which therefore has to outlive the document.
+	class Document {
+	public:
+		explicit Document(std::string_view input);
+
+		const Node& GetRoot() const;
+
+	private:
+		Arena arena_;
+		Node root_;
+	};
+
+}
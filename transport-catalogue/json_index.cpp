@@ -0,0 +1,244 @@
+#include "json_index.h"
+#include "bits.h"
+#include "json.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define JSON_INDEX_X86
+#include <immintrin.h>
+#endif
+
+namespace json {
+
+	using namespace std::literals;
+
+	namespace {
+
+		constexpr size_t BLOCK_SIZE = 64;
+		constexpr size_t WINDOW_BLOCKS = 1024;
+
+		using BlockMasks = StructuralIndex::BlockMasks;
+		using Classifier = StructuralIndex::Classifier;
+
+		void ClassifyPortable(const char* data, size_t count, BlockMasks* masks) {
+			for (size_t block = 0; block < count; ++block, data += BLOCK_SIZE) {
+				BlockMasks& block_masks = masks[block] = BlockMasks{};
+				for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+					const uint64_t bit = uint64_t{ 1 } << i;
+					switch (data[i]) {
+					case '\\': block_masks.backslash |= bit; break;
+					case '"': block_masks.quote |= bit; break;
+					case '{': case '}': case '[': case ']': case ':': case ',': block_masks.structural |= bit; break;
+					case ' ': case '\t': case '\n': case '\r': block_masks.whitespace |= bit; break;
+					default: break;
+					}
+				}
+			}
+		}
+
+#ifdef JSON_INDEX_X86
+		__attribute__((target("avx2")))
+		uint64_t MatchAvx2(__m256i lo, __m256i hi, char c) {
+			const __m256i pattern = _mm256_set1_epi8(c);
+			const uint32_t lo_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, pattern)));
+			const uint32_t hi_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, pattern)));
+			return lo_mask | (uint64_t{ hi_mask } << 32);
+		}
+
+		__attribute__((target("avx2")))
+		void ClassifyAvx2(const char* data, size_t count, BlockMasks* masks) {
+			for (size_t block = 0; block < count; ++block, data += BLOCK_SIZE) {
+				const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+				const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+				masks[block].backslash = MatchAvx2(lo, hi, '\\');
+				masks[block].quote = MatchAvx2(lo, hi, '"');
+				masks[block].structural = MatchAvx2(lo, hi, '{') | MatchAvx2(lo, hi, '}') | MatchAvx2(lo, hi, '[')
+					| MatchAvx2(lo, hi, ']') | MatchAvx2(lo, hi, ':') | MatchAvx2(lo, hi, ',');
+				masks[block].whitespace = MatchAvx2(lo, hi, ' ') | MatchAvx2(lo, hi, '\t') | MatchAvx2(lo, hi, '\n') | MatchAvx2(lo, hi, '\r');
+			}
+		}
+
+		// pcmpestrm compares each byte against a small character set in one instruction.
+		__attribute__((target("sse4.2")))
+		void ClassifySse42(const char* data, size_t count, BlockMasks* masks) {
+			const __m128i structural_set = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+			const __m128i whitespace_set = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+			const __m128i backslash = _mm_set1_epi8('\\');
+			const __m128i quote = _mm_set1_epi8('"');
+			constexpr int MODE = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+
+			for (size_t block = 0; block < count; ++block, data += BLOCK_SIZE) {
+				BlockMasks& block_masks = masks[block] = BlockMasks{};
+				for (size_t part = 0; part < 4; ++part) {
+					const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + part * 16));
+					const size_t shift = part * 16;
+					block_masks.backslash |= uint64_t{ static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash))) } << shift;
+					block_masks.quote |= uint64_t{ static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote))) } << shift;
+					block_masks.structural |= uint64_t{ static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_cmpestrm(structural_set, 6, chunk, 16, MODE))) } << shift;
+					block_masks.whitespace |= uint64_t{ static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_cmpestrm(whitespace_set, 4, chunk, 16, MODE))) } << shift;
+				}
+			}
+		}
+#endif
+
+		struct NamedClassifier {
+			Classifier classify;
+			std::string_view name;
+		};
+
+		// The fastest first.
+		std::vector<NamedClassifier> SupportedImplementations() {
+			std::vector<NamedClassifier> result;
+#ifdef JSON_INDEX_X86
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2")) {
+				result.push_back({ ClassifyAvx2, "avx2"sv });
+			}
+			if (__builtin_cpu_supports("sse4.2")) {
+				result.push_back({ ClassifySse42, "sse4.2"sv });
+			}
+#endif
+			result.push_back({ ClassifyPortable, "portable"sv });
+			return result;
+		}
+
+		const NamedClassifier& GetImplementation() {
+			static const NamedClassifier implementation = SupportedImplementations().front();
+			return implementation;
+		}
+
+		// Bit i is the xor of bits 0..i: set from an opening quote up to, not including, its closing quote.
+		uint64_t PrefixXor(uint64_t bits) {
+			bits ^= bits << 1;
+			bits ^= bits << 2;
+			bits ^= bits << 4;
+			bits ^= bits << 8;
+			bits ^= bits << 16;
+			bits ^= bits << 32;
+			return bits;
+		}
+
+		constexpr size_t WRITE_GROUP = 4;
+
+		// Writes positions in unconditional groups to avoid a mispredicted branch per bit.
+		// Up to WRITE_GROUP - 1 garbage entries land past the end, so buffers carry that slack.
+		uint32_t* WritePositions(uint64_t mask, uint32_t base, uint32_t* out) {
+			const size_t count = static_cast<size_t>(bits::PopCount(mask));
+			for (size_t i = 0; i < count; i += WRITE_GROUP) {
+				for (size_t j = 0; j < WRITE_GROUP; ++j) {
+					out[i + j] = base + static_cast<uint32_t>(bits::CountTrailingZeros(mask | uint64_t{ 1 } << 63));
+					mask &= mask - 1;
+				}
+			}
+			return out + count;
+		}
+
+	}
+
+	StructuralIndex::StructuralIndex(std::string_view input)
+		: input_(input)
+		, classify_(GetImplementation().classify)
+	{
+		if (input.size() > UINT32_MAX) {
+			throw std::length_error("json input is too large to index"s);
+		}
+	}
+
+	StructuralIndex::StructuralIndex(std::string_view input, std::string_view implementation)
+		: StructuralIndex(input)
+	{
+		for (const NamedClassifier& supported : SupportedImplementations()) {
+			if (supported.name == implementation) {
+				classify_ = supported.classify;
+				return;
+			}
+		}
+		throw std::invalid_argument("unsupported structural index implementation "s + std::string(implementation));
+	}
+
+	// Classifies the next window of blocks; returns false once the input is exhausted.
+	// A window can yield at most one position per byte, which sizes the buffers once.
+	bool StructuralIndex::Fill() {
+		if (positions_.empty()) {
+			masks_.resize(WINDOW_BLOCKS);
+			positions_.resize(WINDOW_BLOCKS * BLOCK_SIZE + WRITE_GROUP);
+		}
+
+		count_ = 0;
+		cursor_ = 0;
+		while (count_ == 0 && offset_ < input_.size()) {
+			const size_t window_end = std::min(input_.size(), offset_ + WINDOW_BLOCKS * BLOCK_SIZE);
+			const size_t full_blocks = (window_end - offset_) / BLOCK_SIZE;
+			classify_(input_.data() + offset_, full_blocks, masks_.data());
+
+			size_t blocks = full_blocks;
+			if (offset_ + full_blocks * BLOCK_SIZE < window_end) {
+				char tail[BLOCK_SIZE];
+				std::memset(tail, ' ', BLOCK_SIZE);
+				std::memcpy(tail, input_.data() + offset_ + full_blocks * BLOCK_SIZE, window_end - offset_ - full_blocks * BLOCK_SIZE);
+				classify_(tail, 1, masks_.data() + blocks++);
+			}
+
+			uint32_t* out = positions_.data();
+			for (size_t block = 0; block < blocks; ++block) {
+				out = WritePositions(ScanBlock(masks_[block]), static_cast<uint32_t>(offset_ + block * BLOCK_SIZE), out);
+			}
+			count_ = out - positions_.data();
+			offset_ = window_end;
+		}
+
+		if (offset_ == input_.size() && prev_in_string_ != 0) {
+			throw ParsingError("String parsing error"s);
+		}
+		return count_ != 0;
+	}
+
+	uint64_t StructuralIndex::ScanBlock(const BlockMasks& masks) {
+		const uint64_t escaped = FindEscaped(masks.backslash);
+		const uint64_t quote = masks.quote & ~escaped;
+
+		const uint64_t in_string = PrefixXor(quote) ^ prev_in_string_;
+		prev_in_string_ = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+		const uint64_t scalar = ~(masks.structural | masks.whitespace | quote);
+		const uint64_t scalar_start = scalar & ~(scalar << 1 | prev_scalar_);
+		prev_scalar_ = scalar >> 63;
+
+		return ((masks.structural | scalar_start) & ~in_string) | quote;
+	}
+
+	// Backslashes are rare, so they are walked one by one: each unescaped backslash
+	// escapes the next character, possibly the first one of the next block.
+	uint64_t StructuralIndex::FindEscaped(uint64_t backslash) {
+		uint64_t escaped = prev_escaped_;
+		backslash &= ~prev_escaped_;
+		prev_escaped_ = 0;
+		while (backslash) {
+			const uint64_t bit = backslash & (~backslash + 1);
+			const uint64_t next = bit << 1;
+			if (next == 0) {
+				prev_escaped_ = 1;
+			}
+			escaped |= next;
+			backslash &= ~(bit | next);
+		}
+		return escaped;
+	}
+
+	std::string_view StructuralIndex::Implementation() {
+		return GetImplementation().name;
+	}
+
+	std::vector<std::string_view> StructuralIndex::Implementations() {
+		std::vector<std::string_view> result;
+		for (const NamedClassifier& supported : SupportedImplementations()) {
+			result.push_back(supported.name);
+		}
+		return result;
+	}
+
+}
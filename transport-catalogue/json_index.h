@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+	// Finds the tokens of a JSON text without parsing it, for splitting a document into
+	// parts. Yields, in order, the offsets of every structural character ({}[]:,) outside
+	// strings, of every unescaped quote (opening and closing) and of the first character
+	// of every number or literal.
+	// The input is classified a window of 64-byte blocks at a time with SIMD where
+	// the CPU allows, so the index never holds more than one window of offsets.
+	// Inputs are limited to 4 GiB.
+	class StructuralIndex {
+	public:
+		// One bit per byte of a 64-byte block.
+		struct BlockMasks {
+			uint64_t backslash = 0;
+			uint64_t quote = 0;
+			uint64_t structural = 0;
+			uint64_t whitespace = 0;
+		};
+
+		// Classifies count whole blocks; one call per window keeps the SIMD loop free of indirect calls.
+		using Classifier = void (*)(const char* data, size_t count, BlockMasks* masks);
+
+		explicit StructuralIndex(std::string_view input);
+		// With the named implementation, one of Implementations(), instead of the one
+		// picked for this CPU; for tests and benchmarks.
+		StructuralIndex(std::string_view input, std::string_view implementation);
+
+		// Returns false at the end of input.
+		bool Next(uint32_t& position) {
+			if (cursor_ == count_ && !Fill()) {
+				return false;
+			}
+			position = positions_[cursor_++];
+			return true;
+		}
+
+		bool Peek(uint32_t& position) {
+			if (cursor_ == count_ && !Fill()) {
+				return false;
+			}
+			position = positions_[cursor_];
+			return true;
+		}
+
+		// The implementation picked for this CPU: "avx2", "sse4.2" or "portable".
+		static std::string_view Implementation();
+		// Every implementation this CPU can run, the picked one first.
+		static std::vector<std::string_view> Implementations();
+
+	private:
+		bool Fill();
+		uint64_t ScanBlock(const BlockMasks& masks);
+		uint64_t FindEscaped(uint64_t backslash);
+
+		std::string_view input_;
+		Classifier classify_;
+		size_t offset_ = 0;
+		std::vector<BlockMasks> masks_;
+		std::vector<uint32_t> positions_;
+		size_t count_ = 0;
+		size_t cursor_ = 0;
+
+		uint64_t prev_in_string_ = 0;
+		uint64_t prev_scalar_ = 0;
+		uint64_t prev_escaped_ = 0;
+	};
+
+}
@@ -1,4 +1,7 @@
 #include "json_reader.h"
+#include "json_binding.h"
+#include "json_index.h"
+#include "parallel.h"
 
 
 #include <iomanip>
@@ -7,36 +10,421 @@
 #include <cassert>
 #include <sstream>
 #include <string>
+#include <map>
+#include <optional>
 
 
 namespace json::reader {
 
 	using namespace std;
 
-	std::vector<std::shared_ptr<Stop>> ParseStop(const json::Array& base_requests) {
-		std::vector<std::shared_ptr<Stop>> result;
-		for (const auto& request : base_requests) {
-			const std::string& type = request.AsMap().at("type"s).AsString();
-			if (type == "Stop"s) {
-				auto stop = std::make_shared<Stop>();
-				stop->Parse(request.AsMap());
-				result.push_back(stop);
+	namespace {
+
+		// The stops and buses of a run of base_requests elements, with the name ids of
+		// their names in data.names, in the same order.
+		struct BaseItems {
+			BaseData data;
+			std::vector<NamePool::Id> stop_names;
+			std::vector<NamePool::Id> bus_names;
+		};
+
+		// Builds stops and buses straight from the events of base_requests. The other
+		// top-level sections are small and are collected into nodes for the Parse* helpers.
+		class BaseRequestsHandler final : public json::SaxHandler {
+		public:
+			BaseRequestsHandler() = default;
+
+			// With elements_only the events are those of base_requests elements alone,
+			// without the document and the array around them.
+			explicit BaseRequestsHandler(bool elements_only) {
+				if (elements_only) {
+					depth_ = 2;
+					field_ = Field::BASE_REQUESTS;
+				}
 			}
-		}
-		return result;
-	}
 
-	std::vector<std::shared_ptr<Bus>> ParseBus(const json::Array& base_requests) {
-		std::vector<std::shared_ptr<Bus>> result;
-		for (const auto& request : base_requests) {
-			const std::string& type = request.AsMap().at("type"s).AsString();
-			if (type == "Bus"s) {
-				auto bus = std::make_shared<Bus>();
-				bus->Parse(request.AsMap());
-				result.push_back(bus);
+			void Null() override {
+				if (Delegate([](json::NodeHandler& node) { node.Null(); })) return;
+				Scalar();
 			}
-		}
-		return result;
+
+			void Bool(bool value) override {
+				if (Delegate([value](json::NodeHandler& node) { node.Bool(value); })) return;
+				if (Scalar() == Field::IS_ROUNDTRIP) {
+					item_.is_roundtrip = value;
+				}
+				else if (field_ != Field::OTHER) {
+					throw json::ParsingError("Base request invalid"s);
+				}
+			}
+
+			void Int(int value) override {
+				if (Delegate([value](json::NodeHandler& node) { node.Int(value); })) return;
+				const Field field = Scalar();
+				if (field == Field::ROAD_DISTANCES && depth_ == 4) {
+					item_.road_distances.emplace_back(item_.distance_to, value);
+				}
+				else {
+					Number(field, value);
+				}
+			}
+
+			void Double(double value) override {
+				if (Delegate([value](json::NodeHandler& node) { node.Double(value); })) return;
+				Number(Scalar(), value);
+			}
+
+			void String(std::string_view value) override {
+				if (Delegate([value](json::NodeHandler& node) { node.String(value); })) return;
+				switch (Scalar()) {
+				case Field::TYPE: item_.type = value; break;
+				case Field::NAME: item_.name = data_.names.InternId(value); item_.has_name = true; break;
+				case Field::STOPS:
+					if (depth_ != 4) throw json::ParsingError("Base request invalid"s);
+					item_.stops.push_back(data_.names.InternId(value));
+					break;
+				case Field::OTHER: break;
+				default:
+					throw json::ParsingError("Base request invalid"s);
+				}
+			}
+
+			void Key(std::string_view key) override {
+				if (Delegate([key](json::NodeHandler& node) { node.Key(key); })) return;
+				if (skip_depth_ > 0) return;
+
+				if (depth_ == 1) {
+					if (key == "base_requests"sv) {
+						field_ = Field::BASE_REQUESTS;
+					}
+					else {
+						section_name_ = key;
+						section_.emplace();
+					}
+				}
+				else if (depth_ == 3) {
+					field_ = ItemField(key);
+				}
+				else if (depth_ == 4 && field_ == Field::ROAD_DISTANCES) {
+					item_.distance_to = data_.names.InternId(key);
+				}
+			}
+
+			void StartArray() override {
+				if (Delegate([](json::NodeHandler& node) { node.StartArray(); })) return;
+				if (Skip(1)) return;
+
+				if ((depth_ == 1 && field_ == Field::BASE_REQUESTS) || (depth_ == 3 && field_ == Field::STOPS)) {
+					++depth_;
+				}
+				else {
+					throw json::ParsingError("Base request invalid"s);
+				}
+			}
+
+			void EndArray() override {
+				if (Delegate([](json::NodeHandler& node) { node.EndArray(); })) return;
+				if (Skip(-1)) return;
+				--depth_;
+			}
+
+			void StartDict() override {
+				if (Delegate([](json::NodeHandler& node) { node.StartDict(); })) return;
+				if (Skip(1)) return;
+
+				if (depth_ == 0 || (depth_ == 3 && field_ == Field::ROAD_DISTANCES)) {
+					++depth_;
+				}
+				else if (depth_ == 2) {
+					item_ = Item{};
+					field_ = Field::NONE;
+					++depth_;
+				}
+				else {
+					throw json::ParsingError("Base request invalid"s);
+				}
+			}
+
+			void EndDict() override {
+				if (Delegate([](json::NodeHandler& node) { node.EndDict(); })) return;
+				if (Skip(-1)) return;
+
+				if (--depth_ == 2) {
+					AddItem();
+				}
+			}
+
+			BaseData Extract() {
+				if (auto it = sections_.find("render_settings"s); it != sections_.end()) {
+					data_.render_settings = ParseRenderSetting(it->second.AsMap());
+				}
+				if (auto it = sections_.find("routing_settings"s); it != sections_.end()) {
+					data_.routing_settings = ParseRouterSetting(it->second.AsMap());
+				}
+				data_.serialization_file = sections_.at("serialization_settings"s).AsMap().at("file"s).AsString();
+				return std::move(data_);
+			}
+
+			// Only the stops, buses and their names, for elements_only.
+			BaseItems TakeItems() {
+				return { std::move(data_), std::move(stop_names_), std::move(bus_names_) };
+			}
+
+		private:
+			enum class Field {
+				NONE, BASE_REQUESTS, TYPE, NAME, LATITUDE, LONGITUDE, ROAD_DISTANCES, STOPS, IS_ROUNDTRIP, OTHER
+			};
+
+			// The fields of one base request, whichever order its keys come in.
+			// Names are interned as soon as they are read.
+			struct Item {
+				std::string type;
+				NamePool::Id name = 0;
+				bool has_name = false;
+				std::optional<double> latitude;
+				std::optional<double> longitude;
+				std::vector<std::pair<NamePool::Id, int>> road_distances;
+				NamePool::Id distance_to = 0;
+				std::vector<StopId> stops;
+				std::optional<bool> is_roundtrip;
+			};
+
+			static Field ItemField(std::string_view key) {
+				if (key == "type"sv) return Field::TYPE;
+				if (key == "name"sv) return Field::NAME;
+				if (key == "latitude"sv) return Field::LATITUDE;
+				if (key == "longitude"sv) return Field::LONGITUDE;
+				if (key == "road_distances"sv) return Field::ROAD_DISTANCES;
+				if (key == "stops"sv) return Field::STOPS;
+				if (key == "is_roundtrip"sv) return Field::IS_ROUNDTRIP;
+				return Field::OTHER;
+			}
+
+			// Forwards the event to the section being collected, if any.
+			template <typename Event>
+			bool Delegate(Event event) {
+				if (!section_) {
+					return false;
+				}
+				event(*section_);
+				if (section_->IsComplete()) {
+					sections_[std::move(section_name_)] = section_->Extract();
+					section_.reset();
+				}
+				return true;
+			}
+
+			// Tracks containers nested in a value that is ignored.
+			bool Skip(int delta) {
+				if (skip_depth_ > 0) {
+					skip_depth_ += delta;
+					return true;
+				}
+				if (delta > 0 && field_ == Field::OTHER && depth_ >= 3) {
+					skip_depth_ = 1;
+					return true;
+				}
+				return false;
+			}
+
+			// Returns the field a scalar belongs to; OTHER when it is ignored.
+			Field Scalar() const {
+				if (skip_depth_ > 0 || depth_ < 3) {
+					return Field::OTHER;
+				}
+				return field_;
+			}
+
+			void Number(Field field, double value) {
+				if (field == Field::LATITUDE) {
+					item_.latitude = value;
+				}
+				else if (field == Field::LONGITUDE) {
+					item_.longitude = value;
+				}
+				else if (field != Field::OTHER) {
+					throw json::ParsingError("Base request invalid"s);
+				}
+			}
+
+			void AddItem() {
+				if (item_.type != "Stop"s && item_.type != "Bus"s) {
+					throw json::ParsingError(item_.type.empty() ? "Base request without type"s : "Unknown base request type "s + item_.type);
+				}
+				if (!item_.has_name) {
+					throw json::ParsingError(item_.type + " without name"s);
+				}
+
+				if (item_.type == "Stop"s) {
+					if (!item_.latitude || !item_.longitude) {
+						throw json::ParsingError("Stop invalid"s);
+					}
+					Stop& stop = data_.stops.emplace_back();
+					stop.name = data_.names.GetName(item_.name);
+					stop_names_.push_back(item_.name);
+					stop.coordinates = { *item_.latitude, *item_.longitude };
+					stop.road_distanse = std::move(item_.road_distances);
+				}
+				else {
+					if (!item_.is_roundtrip) {
+						throw json::ParsingError("Bus invalid"s);
+					}
+					Bus& bus = data_.buses.emplace_back();
+					bus.name = data_.names.GetName(item_.name);
+					bus_names_.push_back(item_.name);
+					bus.is_roundtrip = *item_.is_roundtrip;
+					bus.stops = std::move(item_.stops);
+				}
+				field_ = Field::BASE_REQUESTS;
+			}
+
+			// 1: root dict, 2: base_requests, 3: one request, 4: its road_distances or stops.
+			int depth_ = 0;
+			int skip_depth_ = 0;
+			Field field_ = Field::NONE;
+			Item item_;
+
+			std::optional<json::NodeHandler> section_;
+			std::string section_name_;
+			std::map<std::string, json::Node> sections_;
+
+			BaseData data_;
+			std::vector<NamePool::Id> stop_names_;
+			std::vector<NamePool::Id> bus_names_;
+		};
+
+		class StatRequestsHandler final : public json::SaxHandler {
+		public:
+			StatRequestsHandler(
+				const std::function<void(const json::Dict&)>& on_settings,
+				const std::function<void(const json::Node&)>& on_request
+			)
+				: on_settings_(on_settings)
+				, on_request_(on_request) {}
+
+			void Null() override {
+				Value([](json::NodeHandler& node) { node.Null(); });
+			}
+
+			void Bool(bool value) override {
+				Value([value](json::NodeHandler& node) { node.Bool(value); });
+			}
+
+			void Int(int value) override {
+				Value([value](json::NodeHandler& node) { node.Int(value); });
+			}
+
+			void Double(double value) override {
+				Value([value](json::NodeHandler& node) { node.Double(value); });
+			}
+
+			void String(std::string_view value) override {
+				Value([value](json::NodeHandler& node) { node.String(value); });
+			}
+
+			void Key(std::string_view key) override {
+				if (!value_ && depth_ == 1) {
+					section_name_ = key;
+					if (section_name_ != "stat_requests"s) {
+						value_.emplace();
+					}
+					return;
+				}
+				Value([key](json::NodeHandler& node) { node.Key(key); });
+			}
+
+			void StartArray() override {
+				if (!value_ && depth_ == 1 && section_name_ == "stat_requests"s) {
+					depth_ = 2;
+					return;
+				}
+				Value([](json::NodeHandler& node) { node.StartArray(); });
+			}
+
+			void EndArray() override {
+				if (!value_ && depth_ == 2) {
+					depth_ = 1;
+					return;
+				}
+				Value([](json::NodeHandler& node) { node.EndArray(); });
+			}
+
+			void StartDict() override {
+				if (!value_ && depth_ == 0) {
+					depth_ = 1;
+					return;
+				}
+				Value([](json::NodeHandler& node) { node.StartDict(); });
+			}
+
+			void EndDict() override {
+				if (!value_ && depth_ == 1) {
+					depth_ = 0;
+					return;
+				}
+				Value([](json::NodeHandler& node) { node.EndDict(); });
+			}
+
+			void Finish() const {
+				if (!has_settings_) {
+					throw json::ParsingError("serialization_settings not found"s);
+				}
+			}
+
+		private:
+			// Feeds a top-level section or one request into value_ and hands it over once complete.
+			template <typename Event>
+			void Value(Event event) {
+				if (!value_) {
+					if (depth_ != 2) {
+						throw json::ParsingError("Request invalid"s);
+					}
+					value_.emplace();
+				}
+				event(*value_);
+				if (!value_->IsComplete()) {
+					return;
+				}
+
+				json::Node node = value_->Extract();
+				value_.reset();
+				if (depth_ == 2) {
+					AddRequest(std::move(node));
+				}
+				else if (section_name_ == "serialization_settings"s) {
+					on_settings_(node.AsMap());
+					has_settings_ = true;
+					for (const json::Node& request : pending_) {
+						on_request_(request);
+					}
+					pending_.clear();
+				}
+			}
+
+			void AddRequest(json::Node request) {
+				if (has_settings_) {
+					on_request_(request);
+				}
+				else if (pending_.size() < MAX_PENDING_REQUESTS) {
+					pending_.push_back(std::move(request));
+				}
+				else {
+					throw json::ParsingError("Too many stat_requests before serialization_settings"s);
+				}
+			}
+
+			const std::function<void(const json::Dict&)>& on_settings_;
+			const std::function<void(const json::Node&)>& on_request_;
+
+			// 1: root dict, 2: stat_requests.
+			int depth_ = 0;
+			std::string section_name_;
+			std::optional<json::NodeHandler> value_;
+
+			bool has_settings_ = false;
+			std::vector<json::Node> pending_;
+		};
+
 	}
 
 	svg::Color ParseColor(const json::Node& node) {
@@ -71,42 +459,314 @@ namespace json::reader {
 		return svg::Color{};
 	}
 
+	namespace {
+
+		using json::binding::Required;
+		using json::binding::Optional;
+
+		void ReadPoint(svg::Point& point, const json::Node& node) {
+			const json::Array& coordinates = node.AsArray();
+			point.x = coordinates.at(0).AsDouble();
+			point.y = coordinates.at(1).AsDouble();
+		}
+
+		void ReadColor(svg::Color& color, const json::Node& node) {
+			color = ParseColor(node);
+		}
+
+		void ReadPalette(std::vector<svg::Color>& palette, const json::Node& node) {
+			for (const auto& color : node.AsArray()) {
+				palette.push_back(ParseColor(color));
+			}
+		}
+
+		constexpr auto RENDER_SETTINGS_SCHEMA = json::binding::MakeSchema<RenderSettings>(
+			Required("width"sv, &RenderSettings::width_),
+			Required("height"sv, &RenderSettings::height_),
+			Required("padding"sv, &RenderSettings::padding_),
+			Required("stop_radius"sv, &RenderSettings::stop_radius_),
+			Required("line_width"sv, &RenderSettings::line_width_),
+			Required("bus_label_font_size"sv, &RenderSettings::bus_label_font_size_),
+			Required("underlayer_width"sv, &RenderSettings::underlayer_width_),
+			Required("stop_label_font_size"sv, &RenderSettings::stop_label_font_size_),
+			Required("bus_label_offset"sv, &RenderSettings::bus_label_offset_, ReadPoint),
+			Required("stop_label_offset"sv, &RenderSettings::stop_label_offset_, ReadPoint),
+			Required("underlayer_color"sv, &RenderSettings::underlayer_color_, ReadColor),
+			Required("color_palette"sv, &RenderSettings::color_palette_, ReadPalette)
+		);
+
+		// Times come in minutes and speeds in km/h; RoutingSettings keeps seconds and m/s.
+		constexpr auto ROUTING_SETTINGS_SCHEMA = json::binding::MakeSchema<RoutingSettings>(
+			Required("bus_wait_time"sv, &RoutingSettings::bus_wait_time, [](seconds& time, const json::Node& node) {
+				time = node.AsInt() * 60;
+			}),
+			Required("bus_velocity"sv, &RoutingSettings::bus_velocity, [](m_c& velocity, const json::Node& node) {
+				velocity = node.AsDouble() / 3.6;
+			}),
+			Optional("routing_engine"sv, &RoutingSettings::engine, [](RoutingEngine& engine, const json::Node& node) {
+				const std::string& name = node.AsString();
+				if (name == "table"s) {
+					engine = RoutingEngine::TABLE;
+				}
+				else if (name == "overlay"s) {
+					engine = RoutingEngine::OVERLAY;
+				}
+				else if (name != "auto"s) {
+					throw json::ParsingError("unknown routing engine"s);
+				}
+			}),
+			Optional("walking_radius"sv, &RoutingSettings::walk_radius),
+			Optional("walking_speed"sv, &RoutingSettings::walk_velocity, [](m_c& velocity, const json::Node& node) {
+				velocity = node.AsDouble() / 3.6;
+			})
+		);
+
+	}
+
 	transport::render::RenderSettings ParseRenderSetting(const json::Dict& render_settings) {
 		transport::render::RenderSettings result;
+		RENDER_SETTINGS_SCHEMA.Read(render_settings, result);
+		return result;
+	}
+
+	RoutingSettings ParseRouterSetting(const json::Dict& router_settings) {
+		RoutingSettings result;
+		ROUTING_SETTINGS_SCHEMA.Read(router_settings, result);
+		return result;
+	}
+
+	namespace {
+
+		// Below this much input per worker splitting does not pay off.
+		constexpr size_t MIN_PART_SIZE = 1 << 20;
+
+		// The document cut up by one pass over its structural index: the members of the
+		// root dict other than base_requests, and the elements of base_requests cut at
+		// the commas between them into runs of roughly equal size.
+		struct BaseDocument {
+			std::vector<std::pair<std::string_view, std::string_view>> members;
+			std::vector<std::string_view> runs;
+		};
 
-		result.width_ = render_settings.at("width"s).AsDouble();
-		result.height_ = render_settings.at("height"s).AsDouble();
-		result.padding_ = render_settings.at("padding"s).AsDouble();
-		result.stop_radius_ = render_settings.at("stop_radius"s).AsDouble();
-		result.line_width_ = render_settings.at("line_width"s).AsDouble();
-		result.bus_label_font_size_ = render_settings.at("bus_label_font_size"s).AsInt();
-		result.underlayer_width_ = render_settings.at("underlayer_width"s).AsDouble();
-		result.stop_label_font_size_ = render_settings.at("stop_label_font_size"s).AsInt();
+		// Follows only nesting and the tokens of the root dict. Empty when the input has
+		// no base_requests array or anything at the root the pass does not expect, such
+		// as escaped keys or malformed members; the single pass then reads it, and reports
+		// what is wrong.
+		std::optional<BaseDocument> SplitBaseRequests(std::string_view input, size_t parts) {
+			// Where the pass is within a member of the root dict.
+			enum class Expect {
+				KEY, COLON, VALUE, END
+			};
 
-		const json::Array& tmp_bus_label_offset = render_settings.at("bus_label_offset"s).AsArray();	
-		result.bus_label_offset_.x = tmp_bus_label_offset[0].AsDouble();
-		result.bus_label_offset_.y = tmp_bus_label_offset[1].AsDouble();
+			json::StructuralIndex index(input);
+			BaseDocument result;
+			Expect expect = Expect::KEY;
+			int depth = 0;
+			bool in_string = false;
+			size_t string_begin = 0;
+			std::string_view key;
+			size_t value_begin = 0;
+			bool in_array = false;
+			bool has_array = false;
+			size_t run_begin = 0;
+			size_t step = 0;
+			size_t next_cut = 0;
 
-		const json::Array& tmp_stop_label_offset = render_settings.at("stop_label_offset"s).AsArray();
-		result.stop_label_offset_.x = tmp_stop_label_offset[0].AsDouble();
-		result.stop_label_offset_.y = tmp_stop_label_offset[1].AsDouble();
+			// A member of the root dict ends at position.
+			auto end_member = [&](size_t position) {
+				if (key != "base_requests"sv) {
+					result.members.emplace_back(key, input.substr(value_begin, position - value_begin));
+				}
+				expect = Expect::KEY;
+			};
 
-		result.underlayer_color_ = ParseColor(render_settings.at("underlayer_color"s));
+			uint32_t position = 0;
+			if (!index.Next(position) || input[position] != '{') {
+				return std::nullopt;
+			}
+			depth = 1;
+
+			while (index.Next(position)) {
+				const char c = input[position];
+				if (depth == 1 && c != '"' && c != ',' && c != '}') {
+					// Inside a member only its colon and the first token of its value are seen at this depth.
+					if (c == ':' ? expect != Expect::COLON : expect != Expect::VALUE) {
+						return std::nullopt;
+					}
+					expect = c == ':' ? Expect::VALUE : Expect::END;
+					if (c == ':') {
+						value_begin = position + 1;
+					}
+				}
 
-		for (const auto& color : render_settings.at("color_palette"s).AsArray()) {
-			result.color_palette_.push_back(ParseColor(color));
+				switch (c) {
+				case '"':
+					if (!in_string) {
+						string_begin = position + 1;
+						if (depth == 1 && expect != Expect::KEY && expect != Expect::VALUE) {
+							return std::nullopt;
+						}
+					}
+					else if (depth == 1) {
+						if (expect == Expect::KEY) {
+							key = input.substr(string_begin, position - string_begin);
+							if (key.find('\\') != std::string_view::npos) {
+								return std::nullopt;
+							}
+							expect = Expect::COLON;
+						}
+						else {
+							expect = Expect::END;
+						}
+					}
+					in_string = !in_string;
+					break;
+				case '[':
+					if (depth == 1 && key == "base_requests"sv) {
+						if (has_array) {
+							return std::nullopt;
+						}
+						in_array = has_array = true;
+						run_begin = position + 1;
+						step = (input.size() - run_begin) / parts;
+						next_cut = run_begin + step;
+					}
+					++depth;
+					break;
+				case '{':
+					++depth;
+					break;
+				case ']':
+				case '}':
+					if (--depth == 1 && in_array) {
+						result.runs.push_back(input.substr(run_begin, position - run_begin));
+						in_array = false;
+					}
+					else if (depth == 0) {
+						// base_requests is there, so the dict is not empty and ends after a value.
+						if (c != '}' || expect != Expect::END) {
+							return std::nullopt;
+						}
+						end_member(position);
+						// Nothing may follow the root dict.
+						if (index.Next(position) || !has_array) {
+							return std::nullopt;
+						}
+						return result;
+					}
+					break;
+				case ',':
+					if (depth == 1) {
+						if (expect != Expect::END) {
+							return std::nullopt;
+						}
+						end_member(position);
+					}
+					else if (in_array && depth == 2 && position >= next_cut && result.runs.size() + 1 < parts) {
+						result.runs.push_back(input.substr(run_begin, position - run_begin));
+						run_begin = position + 1;
+						next_cut = position + step;
+					}
+					break;
+				}
+			}
+			return std::nullopt;
 		}
-		return result;
+
+		// Puts the stops and buses of parts, in order, behind those of target. The names of
+		// every part are interned in target.names first, in their own order, so the pool
+		// ends up exactly as after one pass over the whole input; each part gets a table
+		// from its name ids to those of target. Then the parts are moved over in parallel,
+		// with only table lookups for their names.
+		void AppendItems(BaseData& target, std::vector<BaseItems>& parts) {
+			NamePool& names = target.names;
+			std::vector<std::vector<NamePool::Id>> remaps(parts.size());
+			std::vector<std::pair<size_t, size_t>> offsets(parts.size());
+			for (size_t i = 0; i < parts.size(); ++i) {
+				const NamePool& part_names = parts[i].data.names;
+				remaps[i].resize(part_names.Size());
+				for (NamePool::Id id = 0; id < part_names.Size(); ++id) {
+					remaps[i][id] = names.InternId(part_names.GetName(id));
+				}
+				offsets[i] = { target.stops.size(), target.buses.size() };
+				target.stops.resize(target.stops.size() + parts[i].data.stops.size());
+				target.buses.resize(target.buses.size() + parts[i].data.buses.size());
+			}
+
+			parallel::ForEachIndex(parts.size(), [&](size_t i) {
+				BaseItems& part = parts[i];
+				const std::vector<NamePool::Id>& remap = remaps[i];
+				for (size_t j = 0; j < part.data.stops.size(); ++j) {
+					Stop& stop = part.data.stops[j];
+					stop.name = names.GetName(remap[part.stop_names[j]]);
+					for (auto& [to, distance] : stop.road_distanse) {
+						to = remap[to];
+					}
+					target.stops[offsets[i].first + j] = std::move(stop);
+				}
+				for (size_t j = 0; j < part.data.buses.size(); ++j) {
+					Bus& bus = part.data.buses[j];
+					bus.name = names.GetName(remap[part.bus_names[j]]);
+					for (auto& stop : bus.stops) {
+						stop = remap[stop];
+					}
+					target.buses[offsets[i].second + j] = std::move(bus);
+				}
+			});
+		}
+
 	}
 
-	RoutingSettings ParseRouterSetting(const json::Dict& router_settings) {
+	BaseData LoadBase(std::string_view input, size_t parts) {
+		if (parts == 0) {
+			parts = parallel::WorkerCount(input.size() / MIN_PART_SIZE);
+		}
+		std::optional<BaseDocument> document;
+		if (parts > 1 && input.size() <= UINT32_MAX) {
+			document = SplitBaseRequests(input, parts);
+		}
+		if (!document) {
+			BaseRequestsHandler handler;
+			json::Parse(input, handler);
+			return handler.Extract();
+		}
 
-		RoutingSettings result(
-			router_settings.at("bus_wait_time"s).AsInt(),
-			router_settings.at("bus_velocity"s).AsDouble()
-		);
+		// The runs are read directly, without indexing them again.
+		std::vector<BaseItems> pieces(document->runs.size());
+		parallel::ForEachIndex(pieces.size(), [&document, &pieces](size_t i) {
+			BaseRequestsHandler handler(true);
+			json::ParseSequence(document->runs[i], handler);
+			pieces[i] = handler.TakeItems();
+		});
+
+		// The rest of the document is fed member by member from where it lies in input.
+		BaseRequestsHandler handler;
+		handler.StartDict();
+		for (const auto& [key, value] : document->members) {
+			handler.Key(key);
+			json::ParseSequence(value, handler);
+		}
+		handler.EndDict();
+		BaseData result = handler.Extract();
 
+		AppendItems(result, pieces);
 		return result;
 	}
 
+	BaseData LoadBase(std::istream& input) {
+		BaseRequestsHandler handler;
+		json::Parse(input, handler);
+		return handler.Extract();
+	}
+
+	void ForEachStatRequest(
+		std::istream& input,
+		const std::function<void(const json::Dict&)>& on_settings,
+		const std::function<void(const json::Node&)>& on_request
+	) {
+		StatRequestsHandler handler(on_settings, on_request);
+		json::Parse(input, handler);
+		handler.Finish();
+	}
+
 }
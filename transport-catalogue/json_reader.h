@@ -9,7 +9,10 @@
 #include "transport_router.h"
 
 
+#include <functional>
+#include <istream>
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 
@@ -19,14 +22,42 @@ namespace json::reader {
 	using namespace transport::router;
 	using namespace transport::response;
 
-	std::vector<std::shared_ptr<Stop>> ParseStop(const json::Array& base_requests);
-
-	std::vector<std::shared_ptr<Bus>> ParseBus(const json::Array& base_requests);
-
 	svg::Color ParseColor(const json::Node& node);
 
 	transport::render::RenderSettings ParseRenderSetting(const json::Dict& render_settings);
 
 	RoutingSettings ParseRouterSetting(const json::Dict& router_settings);
 
+	// Everything make_base needs, built from the input in one pass without a DOM
+	// for base_requests. Stops and buses refer to names interned in names.
+	struct BaseData {
+		NamePool names;
+		std::vector<Stop> stops;
+		std::vector<Bus> buses;
+		RenderSettings render_settings;
+		RoutingSettings routing_settings;
+		std::string serialization_file;
+	};
+
+	// Reads input in a single pass by default. With more parts base_requests is cut into
+	// that many pieces that are parsed in parallel and put back together in input order;
+	// 0 picks one part per hardware thread for large inputs. Splitting costs a pass over
+	// the structural index of the whole input, so it only pays off on several cores.
+	BaseData LoadBase(std::string_view input, size_t parts = 1);
+
+	// Reads the document from input through a fixed window in a single pass, so the
+	// input is never held in memory as a whole.
+	BaseData LoadBase(std::istream& input);
+
+	// Calls on_settings with serialization_settings, then on_request for every element of
+	// stat_requests as soon as it is read from input. Requests that come before the settings
+	// are held back until the settings are seen, up to MAX_PENDING_REQUESTS of them.
+	inline constexpr size_t MAX_PENDING_REQUESTS = 1024;
+
+	void ForEachStatRequest(
+		std::istream& input,
+		const std::function<void(const json::Dict&)>& on_settings,
+		const std::function<void(const json::Node&)>& on_request
+	);
+
 }
@@ -0,0 +1,327 @@
+#include "json.h"
+#include "json_index.h"
+#include "json_writer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Checks that numbers and strings read and written by json come back exactly, and that every
+// structural index implementation finds the tokens a character-by-character scan finds.
+namespace {
+
+	int failures = 0;
+
+	void Check(bool condition, string_view what, int line) {
+		if (!condition) {
+			cerr << "json_test.cpp:"sv << line << ": "sv << what << endl;
+			++failures;
+		}
+	}
+
+#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+	bool SameBits(double lhs, double rhs) {
+		return memcmp(&lhs, &rhs, sizeof(double)) == 0;
+	}
+
+	json::Node Read(string_view text) {
+		return json::Load(text).GetRoot();
+	}
+
+	string Print(const json::Node& node) {
+		ostringstream output;
+		node.Print(output);
+		return output.str();
+	}
+
+	string Write(double value) {
+		string output;
+		json::Writer(output).Value(value);
+		return output;
+	}
+
+	string Write(string_view value) {
+		string output;
+		json::Writer(output).Value(value);
+		return output;
+	}
+
+	// Printed by Node and by Writer, the value reads back bit for bit.
+	void CheckRoundTrip(double value) {
+		const string printed = Print(json::Node(value));
+		Check(printed == Write(value), "Node and Writer print " + printed + " alike", __LINE__);
+
+		const json::Node node = Read(printed);
+		Check(node.IsDouble() && SameBits(node.AsDouble(), value), printed + " reads back exactly", __LINE__);
+	}
+
+	void TestRoundTrip() {
+		for (const double value : { 0.0, 1.0, -1.5, 0.1, 6.012, 6.0120000000000005, 1.0 / 3.0, 123456789.125,
+			9007199254740993.0, 5e-324, 2.2250738585072014e-308, 1.7976931348623157e308, -1e-300 }) {
+			CheckRoundTrip(value);
+		}
+
+		mt19937_64 random(39);
+		for (int i = 0; i < 100000; ++i) {
+			const uint64_t bits = random();
+			double value = 0.0;
+			memcpy(&value, &bits, sizeof(double));
+			if (isfinite(value)) {
+				CheckRoundTrip(value);
+			}
+		}
+	}
+
+	// Node and Writer escape strings alike, and the escapes read back as the string.
+	void TestStrings() {
+		const pair<string, string> cases[] = {
+			{ ""s, R"("")"s },
+			{ "plain"s, R"("plain")"s },
+			{ "say \"hi\""s, R"("say \"hi\"")"s },
+			{ "back\\slash\\\\"s, R"("back\\slash\\\\")"s },
+			{ "line\nbreak\r\ttab"s, R"("line\nbreak\r\ttab")"s },
+			{ "\\\"\n"s, R"("\\\"\n")"s },
+		};
+		for (const auto& [value, expected] : cases) {
+			Check(Print(json::Node(value)) == expected, "Node prints " + expected, __LINE__);
+			Check(Write(value) == expected, "Writer writes " + expected, __LINE__);
+			const json::Node node = Read(expected);
+			Check(node.IsString() && node.AsString() == value, expected + " reads back", __LINE__);
+		}
+	}
+
+	void TestIntegers() {
+		CHECK(Read("2147483647"sv).IsInt() && Read("2147483647"sv).AsInt() == 2147483647);
+		CHECK(Read("-2147483648"sv).IsInt() && Read("-2147483648"sv).AsInt() == numeric_limits<int>::min());
+
+		// Out of int range the value is kept as a double.
+		CHECK(Read("2147483648"sv).IsPureDouble() && Read("2147483648"sv).AsDouble() == 2147483648.0);
+		CHECK(Read("-2147483649"sv).IsPureDouble() && Read("-2147483649"sv).AsDouble() == -2147483649.0);
+		CHECK(Read("18446744073709551616"sv).AsDouble() == 18446744073709551616.0);
+		CHECK(Print(Read("2147483648"sv)) == "2147483648"s);
+	}
+
+	void TestExponents() {
+		CHECK(Read("1e5"sv).IsPureDouble() && Read("1e5"sv).AsDouble() == 100000.0);
+		CHECK(Read("1E-3"sv).AsDouble() == 0.001);
+		CHECK(Read("-2.5e+2"sv).AsDouble() == -250.0);
+		CHECK(Read("0e0"sv).IsPureDouble() && Read("0e0"sv).AsDouble() == 0.0);
+		CHECK(Print(json::Node(1e21)) == "1e+21"s);
+		CHECK(Print(json::Node(1e-7)) == "1e-07"s);
+
+		bool thrown = false;
+		try {
+			Read("1e400"sv);
+		}
+		catch (const json::ParsingError&) {
+			thrown = true;
+		}
+		CHECK(thrown);
+
+		for (const string_view bad : { "1e"sv, "1e+"sv, "1."sv, ".5"sv, "-"sv, "[1,]"sv }) {
+			bool rejected = false;
+			try {
+				Read(bad);
+			}
+			catch (const json::ParsingError&) {
+				rejected = true;
+			}
+			Check(rejected, "rejects " + string(bad), __LINE__);
+		}
+	}
+
+	void TestNegativeZero() {
+		CHECK(Print(json::Node(-0.0)) == "-0"s);
+		CHECK(Write(-0.0) == "-0"s);
+
+		const json::Node zero = Read("-0"sv);
+		CHECK(zero.IsPureDouble() && signbit(zero.AsDouble()));
+		CHECK(signbit(Read("-0.0"sv).AsDouble()));
+		CHECK(signbit(Read("-0e3"sv).AsDouble()));
+		CHECK(Read("0"sv).IsInt());
+		CheckRoundTrip(-0.0);
+	}
+
+	// The stream parser hands numbers to the same conversion.
+	class LastDouble final : public json::SaxHandler {
+	public:
+		void Null() override {}
+		void Bool(bool) override {}
+		void Int(int value) override { last = value; }
+		void Double(double value) override { last = value; }
+		void String(string_view) override {}
+		void Key(string_view) override {}
+		void StartArray() override {}
+		void EndArray() override {}
+		void StartDict() override {}
+		void EndDict() override {}
+
+		double last = 0.0;
+	};
+
+	void TestStream() {
+		for (const double value : { 6.0120000000000005, -0.0, 5e-324, 2147483648.0 }) {
+			istringstream input("[" + Write(value) + "]");
+			LastDouble handler;
+			json::Parse(input, handler);
+			Check(SameBits(handler.last, value), Write(value) + " streams back exactly", __LINE__);
+		}
+	}
+
+	// The offsets StructuralIndex has to yield, found one character at a time the way
+	// the direct parser reads them.
+	vector<uint32_t> ScanTokens(string_view input) {
+		vector<uint32_t> tokens;
+		bool in_string = false;
+		bool escaped = false;
+		bool in_scalar = false;
+		for (uint32_t i = 0; i < input.size(); ++i) {
+			const char c = input[i];
+			if (in_string) {
+				if (escaped) {
+					escaped = false;
+				}
+				else if (c == '\\') {
+					escaped = true;
+				}
+				else if (c == '"') {
+					tokens.push_back(i);
+					in_string = false;
+				}
+				continue;
+			}
+			const bool scalar = string_view("{}[]:, \t\n\r\"").find(c) == string_view::npos;
+			if (c == '"') {
+				tokens.push_back(i);
+				in_string = true;
+			}
+			else if (string_view("{}[]:,").find(c) != string_view::npos || (scalar && !in_scalar)) {
+				tokens.push_back(i);
+			}
+			in_scalar = scalar;
+		}
+		return tokens;
+	}
+
+	vector<uint32_t> IndexTokens(string_view input, string_view implementation) {
+		json::StructuralIndex index(input, implementation);
+		vector<uint32_t> tokens;
+		uint32_t position = 0;
+		while (index.Next(position)) {
+			tokens.push_back(position);
+		}
+		return tokens;
+	}
+
+	void CheckIndex(const string& input, string_view what) {
+		const vector<uint32_t> expected = ScanTokens(input);
+		for (const string_view implementation : json::StructuralIndex::Implementations()) {
+			vector<uint32_t> tokens;
+			try {
+				tokens = IndexTokens(input, implementation);
+			}
+			catch (const json::ParsingError&) {
+			}
+			Check(tokens == expected, string(implementation) + " indexes " + string(what), __LINE__);
+		}
+	}
+
+	// Every piece is tried at every offset around a block boundary, and the document
+	// also has to parse, so the pieces are valid JSON.
+	void TestIndexBoundaries() {
+		const vector<string> pieces = {
+			R"({"a\"b": "\"", "c": [1, -2.5e+3, true, null]})",
+			R"(["\\", "\\\"", "\\\\\\\\", "x\\\\\"y"])",
+			R"({"long": ")" + string(150, 'q') + R"(", "n": 123456789012345678901234567890})",
+			R"(["\u0041\n\t", "}{][,:", "\\\\\\\\\\\\\\\\"])",
+		};
+		for (const string& piece : pieces) {
+			for (size_t offset = 40; offset < 140; ++offset) {
+				const string input = string(offset, ' ') + piece;
+				json::Load(input);
+				CheckIndex(input, "\"" + piece.substr(0, 20) + "\" at offset " + to_string(offset));
+			}
+		}
+	}
+
+	// Random documents of strings heavy with backslashes and quotes, longer than one
+	// window of the index.
+	void TestIndexRandom() {
+		mt19937 random(40);
+		uniform_int_distribution<int> pick(0, 9);
+		for (int round = 0; round < 20; ++round) {
+			string input = "["s;
+			while (input.size() < 70000 + round * 1000) {
+				if (input.size() > 1) {
+					input += ", "s;
+				}
+				switch (pick(random) % 4) {
+				case 0:
+					input += to_string(random() % 100000) + "."s + to_string(random() % 1000);
+					break;
+				case 1: {
+					input += '"';
+					for (int i = pick(random) * 7; i > 0; --i) {
+						const int c = pick(random);
+						input += c < 3 ? "\\\\"s : c < 5 ? "\\\""s : c < 6 ? "{:,]"s : "ab"s;
+					}
+					input += '"';
+					break;
+				}
+				case 2:
+					input += "{\"k\\\"\": [true, false, null]}"s;
+					break;
+				default:
+					input += string(pick(random), ' ') + "\"\""s;
+				}
+			}
+			input += "]"s;
+			json::Load(input);
+			CheckIndex(input, "random document " + to_string(round));
+		}
+	}
+
+	void TestIndexUnterminated() {
+		for (const string_view implementation : json::StructuralIndex::Implementations()) {
+			bool thrown = false;
+			try {
+				IndexTokens(R"(["abc\"])", implementation);
+			}
+			catch (const json::ParsingError&) {
+				thrown = true;
+			}
+			Check(thrown, string(implementation) + " rejects an unterminated string", __LINE__);
+		}
+	}
+
+}
+
+int main() {
+	TestRoundTrip();
+	TestStrings();
+	TestIntegers();
+	TestExponents();
+	TestNegativeZero();
+	TestStream();
+	TestIndexBoundaries();
+	TestIndexRandom();
+	TestIndexUnterminated();
+
+	if (failures > 0) {
+		cerr << failures << " checks failed"sv << endl;
+		return 1;
+	}
+	cout << "json_test OK"sv << endl;
+	return 0;
+}
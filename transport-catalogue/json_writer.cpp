@@ -0,0 +1,124 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace json {
+
+	using namespace std::literals;
+
+	Writer& Writer::Key(std::string_view key) {
+		if (after_key_) {
+			throw std::logic_error("dict key entered twice");
+		}
+		BeforeValue();
+		WriteString(key);
+		output_ += ": "sv;
+		after_key_ = true;
+		return *this;
+	}
+
+	Writer& Writer::Value(std::nullptr_t) {
+		BeforeValue();
+		output_ += "null"sv;
+		return *this;
+	}
+
+	Writer& Writer::Value(bool value) {
+		BeforeValue();
+		output_ += value ? "true"sv : "false"sv;
+		return *this;
+	}
+
+	Writer& Writer::Value(int value) {
+		BeforeValue();
+		char buffer[16];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		output_.append(buffer, result.ptr);
+		return *this;
+	}
+
+	// Shortest round-trip form, as json::Print writes it.
+	Writer& Writer::Value(double value) {
+		BeforeValue();
+		char buffer[32];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		output_.append(buffer, result.ptr);
+		return *this;
+	}
+
+	Writer& Writer::Value(std::string_view value) {
+		BeforeValue();
+		WriteString(value);
+		return *this;
+	}
+
+	Writer& Writer::Raw(std::string_view json) {
+		BeforeValue();
+		output_ += json;
+		return *this;
+	}
+
+	Writer& Writer::BeginArray() {
+		Begin('[');
+		return *this;
+	}
+
+	Writer& Writer::EndArray() {
+		End(']');
+		return *this;
+	}
+
+	Writer& Writer::BeginDict() {
+		Begin('{');
+		return *this;
+	}
+
+	Writer& Writer::EndDict() {
+		End('}');
+		return *this;
+	}
+
+	// A value right after a key belongs to it; anything else is a new container element.
+	void Writer::BeforeValue() {
+		if (after_key_) {
+			after_key_ = false;
+			return;
+		}
+		if (depth_ == 0) {
+			return;
+		}
+		const uint64_t bit = uint64_t{ 1 } << (depth_ - 1);
+		if (has_elements_ & bit) {
+			output_ += ", "sv;
+		}
+		has_elements_ |= bit;
+	}
+
+	void Writer::Begin(char bracket) {
+		if (depth_ == MAX_DEPTH) {
+			throw std::logic_error("json nesting is too deep");
+		}
+		BeforeValue();
+		output_ += bracket;
+		++depth_;
+		has_elements_ &= ~(uint64_t{ 1 } << (depth_ - 1));
+	}
+
+	void Writer::End(char bracket) {
+		if (depth_ == 0 || after_key_) {
+			throw std::logic_error("unexpected end of container");
+		}
+		--depth_;
+		output_ += bracket;
+	}
+
+	void Writer::WriteString(std::string_view value) {
+		output_ += '"';
+		WriteEscaped(value, [this](std::string_view piece) {
+			output_ += piece;
+		});
+		output_ += '"';
+	}
+
+}
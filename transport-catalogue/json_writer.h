@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace json {
+
+	// Passes value to write as the body of a JSON string: the runs of characters that need
+	// no escape and the escapes between them. Writer and Node::Print both escape with it.
+	template <typename Write>
+	void WriteEscaped(std::string_view value, Write write) {
+		using namespace std::literals;
+
+		size_t run = 0;
+		for (size_t i = 0; i < value.size(); ++i) {
+			std::string_view escaped;
+			switch (value[i]) {
+			case '\\': escaped = "\\\\"sv; break;
+			case '"': escaped = "\\\""sv; break;
+			case '\n': escaped = "\\n"sv; break;
+			case '\r': escaped = "\\r"sv; break;
+			case '\t': escaped = "\\t"sv; break;
+			default: continue;
+			}
+			write(value.substr(run, i - run));
+			write(escaped);
+			run = i + 1;
+		}
+		write(value.substr(run));
+	}
+
+	// Writes JSON text straight into a caller-owned buffer, in the same format as
+	// json::Print. Nothing is allocated besides growing the buffer, so reusing one
+	// buffer makes writing allocation free. The caller may clear the buffer between
+	// calls, e.g. after flushing it, while an array is still open.
+	class Writer {
+	public:
+		explicit Writer(std::string& output)
+			: output_(output) {}
+
+		Writer& Key(std::string_view key);
+
+		Writer& Value(std::nullptr_t);
+		Writer& Value(bool value);
+		Writer& Value(int value);
+		Writer& Value(double value);
+		Writer& Value(std::string_view value);
+		Writer& Value(const char* value) {
+			return Value(std::string_view(value));
+		}
+
+		// Writes a value that is already JSON text, escaped and quoted where needed, as is.
+		Writer& Raw(std::string_view json);
+
+		Writer& BeginArray();
+		Writer& EndArray();
+		Writer& BeginDict();
+		Writer& EndDict();
+
+	private:
+		// Containers deeper than this are rejected; one bit per level tells whether it has elements.
+		static constexpr int MAX_DEPTH = 64;
+
+		void BeforeValue();
+		void Begin(char bracket);
+		void End(char bracket);
+		void WriteString(std::string_view value);
+
+		std::string& output_;
+		int depth_ = 0;
+		uint64_t has_elements_ = 0;
+		bool after_key_ = false;
+	};
+
+}
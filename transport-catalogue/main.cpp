@@ -2,6 +2,7 @@
 #include "json_reader.h"
 #include "transport_catalogue.h"
 #include "request_handler.h"
+#include "output_sink.h"
 
 #include <iostream>
 #include <fstream>
@@ -9,6 +10,8 @@
 #include <string>
 #include <sstream>
 #include <cassert>
+#include <exception>
+#include <optional>
 
 using namespace std;
 using namespace transport::catalogue;
@@ -25,36 +28,163 @@ string ReadFile(const string& file_name) {
 	return str;
 }
 
-int main(int argc, const char* argv[]) {
-	if (argc != 2) {
-		cerr << "Usage: transport_catalogue [make_base|process_requests]\n"s;
-		return 5;
+// Answers stat_requests one by one as they are parsed, without a DOM for the whole input.
+void ProcessRequestsStream(istream& input, ostream& output) {
+	TransportCatalogue mainBD;
+	RequestHelper requests(mainBD);
+
+	io::Sink sink(output);
+	string response;
+	json::Writer writer(response);
+	writer.BeginArray();
+	json::reader::ForEachStatRequest(
+		input,
+		[&mainBD](const json::Dict& settings) {
+			mainBD.Deserialize(ReadFile(settings.at("file").AsString()));
+		},
+		[&](const json::Node& request) {
+			requests.Respond(RequestHelper::ParseRequest(request), writer);
+			sink << response;
+			response.clear();
+		}
+	);
+	writer.EndArray();
+	sink << response;
+	sink.Flush();
+}
+
+// The answer to a line that could not be handled, with the id of the request if it has one.
+void WriteLineError(string& response, optional<int> request_id, string_view message) {
+	json::Writer writer(response);
+	writer.BeginDict().Key("error_message"sv).Value(message);
+	if (request_id) {
+		writer.Key("request_id"sv).Value(*request_id);
+	}
+	writer.EndDict();
+}
+
+// The first line holds serialization_settings, every following line is one request;
+// each response is written on its own line. A line that fails gets an error object as
+// its response and the ones after it are still answered.
+void ProcessRequestsNdjson(istream& input, ostream& output) {
+	TransportCatalogue mainBD;
+	RequestHelper requests(mainBD);
+	bool loaded = false;
+
+	io::Sink sink(output);
+	string line;
+	string response;
+	while (getline(input, line)) {
+		if (line.find_first_not_of(" \t\r"s) == string::npos) {
+			continue;
+		}
+
+		optional<int> request_id;
+		try {
+			const auto doc = json::Load(string_view(line));
+			const json::Node& root = doc.GetRoot();
+			if (root.IsMap()) {
+				if (const auto it = root.AsMap().find("id"s); it != root.AsMap().end() && it->second.IsInt()) {
+					request_id = it->second.AsInt();
+				}
+			}
+
+			if (loaded) {
+				json::Writer writer(response);
+				requests.Respond(RequestHelper::ParseRequest(root), writer);
+			}
+			else {
+				mainBD.Deserialize(ReadFile(root.AsMap().at("serialization_settings").AsMap().at("file").AsString()));
+				loaded = true;
+			}
+		}
+		catch (const exception& error) {
+			response.clear();
+			WriteLineError(response, request_id, error.what());
+		}
+		if (response.empty()) {
+			continue;
+		}
+
+		response += '\n';
+		sink << response;
+		response.clear();
+
+		// An interactive client waits for the answer before sending more.
+		if (input.rdbuf()->in_avail() <= 0) {
+			sink.Flush();
+		}
 	}
+	sink.Flush();
+}
 
-	const string_view mode(argv[1]);
+// The number of parts for LoadBase from --parallel (0: one per hardware thread) or --parallel=N.
+optional<size_t> ParseParallelOption(string_view option) {
+	const string_view prefix = "--parallel"sv;
+	if (option.substr(0, prefix.size()) != prefix) {
+		return nullopt;
+	}
+	option.remove_prefix(prefix.size());
+	if (option.empty()) {
+		return 0;
+	}
+	if (option[0] != '=' || option.size() == 1 || option.size() > 4) {
+		return nullopt;
+	}
+	size_t parts = 0;
+	for (const char c : option.substr(1)) {
+		if (c < '0' || c > '9') {
+			return nullopt;
+		}
+		parts = parts * 10 + (c - '0');
+	}
+	if (parts == 0) {
+		return nullopt;
+	}
+	return parts;
+}
 
-	const auto input_doc = json::Load(cin);
-	const auto& input_map = input_doc.GetRoot().AsMap();
+int main(int argc, const char* argv[]) {
+	const string_view mode(argc > 1 ? argv[1] : "");
+	const string_view option(argc == 3 ? argv[2] : "");
+	const optional<size_t> parts = ParseParallelOption(option);
+
+	if ((argc != 2 && argc != 3) || (mode == "make_base"sv && !option.empty() && !parts)) {
+		cerr << "Usage: transport_catalogue [make_base [--parallel[=N]]|process_requests [--stream|--ndjson]]\n"s;
+		return 5;
+	}
 
 	if (mode == "make_base") {
 
-		std::vector<std::shared_ptr<Stop>> stops = json::reader::ParseStop(input_map.at("base_requests").AsArray());
-		std::vector<std::shared_ptr<Bus>> buses = json::reader::ParseBus(input_map.at("base_requests").AsArray());
+		// The whole input is needed to cut base_requests into parts; a single pass reads it
+		// through a window instead.
+		json::reader::BaseData base = parts
+			? json::reader::LoadBase(json::ReadAll(cin), *parts)
+			: json::reader::LoadBase(cin);
 
 		TransportCatalogue mainBD(
-			stops,
-			buses,
-			json::reader::ParseRenderSetting(input_map.at("render_settings").AsMap()),
-			json::reader::ParseRouterSetting(input_map.at("routing_settings").AsMap())
+			std::move(base.names),
+			std::move(base.stops),
+			std::move(base.buses),
+			base.render_settings,
+			base.routing_settings
 		);
 
-		const string& file_name = input_map.at("serialization_settings").AsMap().at("file").AsString();
-		ofstream file(file_name);
+		ofstream file(base.serialization_file);
 		file << mainBD.Serialize();
 	}
+	else if (mode == "process_requests" && option == "--stream") {
+		ProcessRequestsStream(cin, cout);
+	}
+	else if (mode == "process_requests" && option == "--ndjson") {
+		ProcessRequestsNdjson(cin, cout);
+	}
 	else if (mode == "process_requests") {
 
-		const string& file_name = input_map.at("serialization_settings").AsMap().at("file").AsString();
+		const string input = json::ReadAll(cin);
+		const json::flat::Document input_doc(input);
+		const auto input_map = input_doc.GetRoot().AsMap();
+		const string file_name(input_map.at("serialization_settings").AsMap().at("file").AsString());
 		
 		TransportCatalogue mainBD;
 		mainBD.Deserialize(ReadFile(file_name));
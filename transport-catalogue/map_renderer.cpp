@@ -19,8 +19,8 @@ namespace transport::render {
 	using namespace std::literals;
 	
 	MapRenderer::MapRenderer(
-		std::map<std::string_view, std::shared_ptr<Stop>>& stops_unique,
-		std::map<std::string_view, std::shared_ptr<Bus>>& buses_unique,
+		const std::vector<Stop>& stops_unique,
+		const std::vector<Bus>& buses_unique,
 		RenderSettings settings
 	)
 		: stops_unique_(stops_unique)
@@ -39,15 +39,16 @@ namespace transport::render {
 		CreateStopPoint(result);
 		CreateStopName(result);
 		
-		std::stringstream  render;
-		result.Render(render);
-		return render.str();
+		std::string render;
+		io::Sink sink(render);
+		result.Render(sink);
+		return render;
 	}
 
 	void MapRenderer::CreateRoutes(svg::Document& result) const {
 		size_t color = 0;
-		for (const auto& [_, bus] : buses_unique_) {
-			if (bus->unique_stop_count < 2) continue;
+		for (const Bus& bus : buses_unique_) {
+			if (bus.unique_stop_count < 2) continue;
 
 			svg::Polyline route_line = svg::Polyline()
 				.SetStrokeColor(settings_.color_palette_[color])
@@ -56,13 +57,13 @@ namespace transport::render {
 				.SetStrokeLineCap(svg::StrokeLineCap::ROUND)
 				.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-			for (const std::string& stop : bus->stops) {
-				route_line.AddPoint(scaler_->operator()(stops_unique_.at(stop)->coordinates));
+			for (const StopId stop : bus.stops) {
+				route_line.AddPoint(scaler_->operator()(stops_unique_[stop].coordinates));
 			}
 
-			if (!bus->is_roundtrip) {
-				for (int stop = bus->stops.size() - 2; stop > -1; stop--) {
-					route_line.AddPoint(scaler_->operator()(stops_unique_.at(bus->stops[stop])->coordinates));
+			if (!bus.is_roundtrip) {
+				for (int stop = bus.stops.size() - 2; stop > -1; stop--) {
+					route_line.AddPoint(scaler_->operator()(stops_unique_[bus.stops[stop]].coordinates));
 				}
 			}
 
@@ -75,7 +76,7 @@ namespace transport::render {
 	
 	void MapRenderer::CreateRouteNumber(svg::Document& result) const {
 		int color = 0;
-		for (const auto& [_, bus] : buses_unique_) {
+		for (const Bus& bus : buses_unique_) {
 
 			std::vector<svg::Text> bus_numbers;
 
@@ -86,26 +87,26 @@ namespace transport::render {
 				.SetFontWeight("bold")
 				.SetStrokeLineCap(svg::StrokeLineCap::ROUND)
 				.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
-				.SetPosition(scaler_->operator()(stops_unique_.at(bus->stops[0])->coordinates))
+				.SetPosition(scaler_->operator()(stops_unique_[bus.stops[0]].coordinates))
 				.SetOffset(settings_.bus_label_offset_)
 				.SetFontSize(settings_.bus_label_font_size_)
 				.SetFontFamily("Verdana")
-				.SetData(bus->name);
+				.SetData(std::string(bus.name));
 			bus_numbers.push_back(first_background);
 
 			svg::Text first_number = svg::Text()
 				.SetFillColor(settings_.color_palette_[color])
 				.SetFontWeight("bold")
-				.SetPosition(scaler_->operator()(stops_unique_.at(bus->stops[0])->coordinates))
+				.SetPosition(scaler_->operator()(stops_unique_[bus.stops[0]].coordinates))
 				.SetOffset(settings_.bus_label_offset_)
 				.SetFontSize(settings_.bus_label_font_size_)
 				.SetFontFamily("Verdana")
-				.SetData(bus->name);
+				.SetData(std::string(bus.name));
 
 			bus_numbers.push_back(first_number);
 
-			if (!bus->is_roundtrip) {
-				if (bus->stops.size() > 1 && stops_unique_.at(bus->stops[0])->name != stops_unique_.at(bus->stops[bus->stops.size() - 1])->name) {
+			if (!bus.is_roundtrip) {
+				if (bus.stops.size() > 1 && bus.stops[0] != bus.stops[bus.stops.size() - 1]) {
 					svg::Text second_background = svg::Text()
 						.SetFillColor(settings_.underlayer_color_)
 						.SetStrokeColor(settings_.underlayer_color_)
@@ -113,21 +114,21 @@ namespace transport::render {
 						.SetFontWeight("bold")
 						.SetStrokeLineCap(svg::StrokeLineCap::ROUND)
 						.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
-						.SetPosition(scaler_->operator()(stops_unique_.at(bus->stops[bus->stops.size() - 1])->coordinates))
+						.SetPosition(scaler_->operator()(stops_unique_[bus.stops[bus.stops.size() - 1]].coordinates))
 						.SetOffset(settings_.bus_label_offset_)
 						.SetFontSize(settings_.bus_label_font_size_)
 						.SetFontFamily("Verdana")
-						.SetData(bus->name);
+						.SetData(std::string(bus.name));
 					bus_numbers.push_back(second_background);
 
 					svg::Text second_number = svg::Text()
 						.SetFillColor(settings_.color_palette_[color])
 						.SetFontWeight("bold")
-						.SetPosition(scaler_->operator()(stops_unique_.at(bus->stops[bus->stops.size() - 1])->coordinates))
+						.SetPosition(scaler_->operator()(stops_unique_[bus.stops[bus.stops.size() - 1]].coordinates))
 						.SetOffset(settings_.bus_label_offset_)
 						.SetFontSize(settings_.bus_label_font_size_)
 						.SetFontFamily("Verdana")
-						.SetData(bus->name);
+						.SetData(std::string(bus.name));
 
 					bus_numbers.push_back(second_number);
 				}
@@ -144,9 +145,9 @@ namespace transport::render {
 	}
 
 	void MapRenderer::CreateStopPoint(svg::Document& result) const {
-		for (const auto& [_, stop] : stops_unique_) {
+		for (const Stop& stop : stops_unique_) {
 			svg::Circle point = svg::Circle()
-				.SetCenter(scaler_->operator()(stop->coordinates))
+				.SetCenter(scaler_->operator()(stop.coordinates))
 				.SetRadius(settings_.stop_radius_)
 				.SetFillColor("white"s);
 			result.Add(point);
@@ -154,10 +155,10 @@ namespace transport::render {
 	}
 
 	void MapRenderer::CreateStopName(svg::Document& result) const {
-		for (const auto& [_, stop] : stops_unique_) {
+		for (const Stop& stop : stops_unique_) {
 			svg::Text background = svg::Text()
-				.SetData(stop->name)
-				.SetPosition(scaler_->operator()(stop->coordinates))
+				.SetData(std::string(stop.name))
+				.SetPosition(scaler_->operator()(stop.coordinates))
 				.SetOffset(settings_.stop_label_offset_)
 				.SetFontSize(settings_.stop_label_font_size_)
 				.SetFontFamily("Verdana")
@@ -171,8 +172,8 @@ namespace transport::render {
 			result.Add(background);
 
 			svg::Text number = svg::Text()
-				.SetData(stop->name)
-				.SetPosition(scaler_->operator()(stop->coordinates))
+				.SetData(std::string(stop.name))
+				.SetPosition(scaler_->operator()(stop.coordinates))
 				.SetOffset(settings_.stop_label_offset_)
 				.SetFontSize(settings_.stop_label_font_size_)
 				.SetFontFamily("Verdana")
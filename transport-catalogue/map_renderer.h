@@ -53,17 +53,17 @@ namespace transport::render {
 				return;
 			}
 
-			const auto [left_it, right_it] = std::minmax_element(points_begin, points_end, [](auto lhs, auto rhs) {
-				return lhs.second->coordinates.lng < rhs.second->coordinates.lng;
+			const auto [left_it, right_it] = std::minmax_element(points_begin, points_end, [](const auto& lhs, const auto& rhs) {
+				return lhs.coordinates.lng < rhs.coordinates.lng;
 				});
-			min_lon_ = (*left_it).second->coordinates.lng;
-			const double max_lon = (*right_it).second->coordinates.lng;
+			min_lon_ = (*left_it).coordinates.lng;
+			const double max_lon = (*right_it).coordinates.lng;
 
-			const auto [bottom_it, top_it] = std::minmax_element(points_begin, points_end, [](auto lhs, auto rhs) {
-				return lhs.second->coordinates.lat < rhs.second->coordinates.lat;
+			const auto [bottom_it, top_it] = std::minmax_element(points_begin, points_end, [](const auto& lhs, const auto& rhs) {
+				return lhs.coordinates.lat < rhs.coordinates.lat;
 				});
-			const double min_lat = (*bottom_it).second->coordinates.lat;
-			max_lat_ = (*top_it).second->coordinates.lat;
+			const double min_lat = (*bottom_it).coordinates.lat;
+			max_lat_ = (*top_it).coordinates.lat;
 
 			std::optional<double> width_zoom;
 			if (!IsZero(max_lon - min_lon_)) {
@@ -106,9 +106,10 @@ namespace transport::render {
 	class MapRenderer {
 	public:
 
+		// Stops and buses are drawn in the order of their ids.
 		MapRenderer(
-			std::map<std::string_view, std::shared_ptr<Stop>>& stops_unique,
-			std::map<std::string_view, std::shared_ptr<Bus>>& buses_unique,
+			const std::vector<Stop>& stops_unique,
+			const std::vector<Bus>& buses_unique,
 			RenderSettings settings
 		);
 
@@ -118,8 +119,8 @@ namespace transport::render {
 		static RenderSettings DeserializeSettings(const TCProto::RenderSettings& proto);
 
 	private:
-		const std::map<std::string_view, std::shared_ptr<Stop>>& stops_unique_;
-		const std::map<std::string_view, std::shared_ptr<Bus>>& buses_unique_;
+		const std::vector<Stop>& stops_unique_;
+		const std::vector<Bus>& buses_unique_;
 		const RenderSettings settings_;
 		
 		std::unique_ptr<MapScaler> scaler_;
@@ -0,0 +1,127 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace transport::domains {
+
+	NameIndex::NameIndex(const NamePool& names, const std::vector<Stop>& stops, const std::vector<Bus>& buses) {
+		// One entry per distinct name.
+		std::vector<Entry> pending;
+		std::vector<uint32_t> entry_by_name(names.Size(), NO_ID);
+		auto entry_for = [&names, &pending, &entry_by_name](std::string_view name) -> Entry& {
+			const NamePool::Id id = names.GetId(name);
+			if (entry_by_name[id] == NO_ID) {
+				entry_by_name[id] = static_cast<uint32_t>(pending.size());
+				pending.push_back({ id, NO_ID, NO_ID });
+			}
+			return pending[entry_by_name[id]];
+		};
+		for (StopId id = 0; id < stops.size(); ++id) {
+			entry_for(stops[id].name).stop = id;
+		}
+		for (BusId id = 0; id < buses.size(); ++id) {
+			entry_for(buses[id].name).bus = id;
+		}
+
+		if (pending.empty()) {
+			return;
+		}
+		for (seed_ = 0; seed_ < MAX_SEED; ++seed_) {
+			if (TryBuild(pending, names)) {
+				return;
+			}
+		}
+		throw std::runtime_error("no perfect hash for the names");
+	}
+
+	bool NameIndex::TryBuild(const std::vector<Entry>& pending, const NamePool& names) {
+		const size_t count = pending.size();
+		displacements_.assign((count + BUCKET_SIZE - 1) / BUCKET_SIZE, 0);
+		entries_.assign(count, Entry{});
+
+		std::vector<uint64_t> hashes(count);
+		std::vector<std::vector<uint32_t>> buckets(displacements_.size());
+		for (size_t index = 0; index < count; ++index) {
+			hashes[index] = Hash(names.GetName(pending[index].name), seed_);
+			buckets[Bucket(hashes[index])].push_back(static_cast<uint32_t>(index));
+		}
+
+		// The largest buckets go first, while most slots are still free.
+		std::vector<uint32_t> order(buckets.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t lhs, uint32_t rhs) {
+			return buckets[lhs].size() > buckets[rhs].size();
+			});
+
+		std::vector<bool> taken(count, false);
+		std::vector<size_t> slots;
+		for (const uint32_t bucket : order) {
+			const std::vector<uint32_t>& members = buckets[bucket];
+			if (members.empty()) {
+				break;
+			}
+
+			uint32_t displacement = 0;
+			for (;; ++displacement) {
+				if (displacement == MAX_DISPLACEMENT) {
+					return false;
+				}
+				slots.clear();
+				for (const uint32_t index : members) {
+					const size_t slot = Slot(hashes[index], displacement);
+					if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+						break;
+					}
+					slots.push_back(slot);
+				}
+				if (slots.size() == members.size()) {
+					break;
+				}
+			}
+
+			displacements_[bucket] = displacement;
+			for (size_t i = 0; i < members.size(); ++i) {
+				taken[slots[i]] = true;
+				entries_[slots[i]] = pending[members[i]];
+			}
+		}
+		return true;
+	}
+
+	void NameIndex::Serialize(TCProto::NameIndex& proto) const {
+		proto.set_seed(seed_);
+		for (const uint32_t displacement : displacements_) {
+			proto.add_displacements(displacement);
+		}
+		for (const Entry& entry : entries_) {
+			proto.add_names(entry.name);
+			proto.add_stops(entry.stop + 1);
+			proto.add_buses(entry.bus + 1);
+		}
+	}
+
+	NameIndex NameIndex::Deserialize(const TCProto::NameIndex& proto, const NamePool& names, size_t stop_count, size_t bus_count) {
+		const int count = proto.names_size();
+		if (proto.stops_size() != count || proto.buses_size() != count || (count > 0 && proto.displacements_size() == 0)) {
+			throw std::runtime_error("invalid serialized name index");
+		}
+
+		NameIndex index;
+		index.seed_ = proto.seed();
+		index.displacements_.assign(proto.displacements().begin(), proto.displacements().end());
+		index.entries_.resize(count);
+		for (int i = 0; i < count; ++i) {
+			const Entry entry{ proto.names(i), proto.stops(i) - 1, proto.buses(i) - 1 };
+			const bool stop_valid = entry.stop == NO_ID || entry.stop < stop_count;
+			const bool bus_valid = entry.bus == NO_ID || entry.bus < bus_count;
+			if (entry.name >= names.Size() || !stop_valid || !bus_valid || (entry.stop == NO_ID && entry.bus == NO_ID)) {
+				throw std::runtime_error("invalid serialized name index");
+			}
+			index.entries_[i] = entry;
+		}
+		return index;
+	}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "domain.h"
+
+#include "transport_catalogue.pb.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace transport::domains {
+
+	// A minimal perfect hash of the stop and bus names, built once by make_base and
+	// stored in the base (hash and displace, as in CHD). The names are hashed into
+	// buckets of about BUCKET_SIZE; every bucket keeps the displacement that sends its
+	// names to slots no other name took, and there are as many slots as names.
+	// A lookup is one hash, two table reads and one comparison with the slot's name.
+	class NameIndex {
+	public:
+		// A stop and a bus may share a name, so a slot holds both.
+		struct Entry {
+			NamePool::Id name = 0;
+			StopId stop = NO_ID;
+			BusId bus = NO_ID;
+		};
+
+		NameIndex() = default;
+
+		// Stops and buses in the order of their ids, with names interned in names.
+		NameIndex(const NamePool& names, const std::vector<Stop>& stops, const std::vector<Bus>& buses);
+
+		// nullptr when name is neither a stop nor a bus.
+		const Entry* Find(std::string_view name, const NamePool& names) const {
+			if (entries_.empty()) {
+				return nullptr;
+			}
+			const uint64_t hash = Hash(name, seed_);
+			const Entry& entry = entries_[Slot(hash, displacements_[Bucket(hash)])];
+			return names.GetName(entry.name) == name ? &entry : nullptr;
+		}
+
+		void Serialize(TCProto::NameIndex& proto) const;
+		// Checks that every entry refers to a name of names and to one of stop_count stops
+		// and bus_count buses.
+		static NameIndex Deserialize(const TCProto::NameIndex& proto, const NamePool& names, size_t stop_count, size_t bus_count);
+
+	private:
+		static constexpr size_t BUCKET_SIZE = 4;
+		static constexpr uint32_t MAX_DISPLACEMENT = 1 << 22;
+		static constexpr uint64_t MAX_SEED = 64;
+
+		// FNV-1a finished with the splitmix64 mixer. The base is read back by other
+		// processes, so the hash has to be fixed rather than std::hash.
+		static uint64_t Hash(std::string_view name, uint64_t seed) {
+			uint64_t hash = 14695981039346656037ull ^ seed;
+			for (const char c : name) {
+				hash ^= static_cast<uint8_t>(c);
+				hash *= 1099511628211ull;
+			}
+			return Mix(hash);
+		}
+
+		static uint64_t Mix(uint64_t value) {
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+			return value ^ (value >> 31);
+		}
+
+		// Maps the top 32 bits of value onto [0, size) with a multiplication instead of a division.
+		static size_t Reduce(uint64_t value, size_t size) {
+			return static_cast<size_t>(((value >> 32) * size) >> 32);
+		}
+
+		size_t Bucket(uint64_t hash) const {
+			return Reduce(hash, displacements_.size());
+		}
+
+		size_t Slot(uint64_t hash, uint32_t displacement) const {
+			return Reduce(Mix(hash + displacement * 0x9E3779B97F4A7C15ull), entries_.size());
+		}
+
+		bool TryBuild(const std::vector<Entry>& pending, const NamePool& names);
+
+		uint64_t seed_ = 0;
+		std::vector<uint32_t> displacements_;
+		std::vector<Entry> entries_;
+	};
+
+}
@@ -0,0 +1,141 @@
+#include "output_sink.h"
+
+#include <cerrno>
+#include <charconv>
+#include <iostream>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OUTPUT_SINK_WRITEV
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace io {
+
+	Sink::Sink(std::string& output)
+		: buffer_(output) {}
+
+	Sink::Sink(std::ostream& output)
+		: buffer_(own_buffer_)
+	{
+#ifdef OUTPUT_SINK_WRITEV
+		if (&output == &std::cout) {
+			// Whatever cout still holds has to come out first.
+			std::cout.flush();
+			fd_ = STDOUT_FILENO;
+		}
+		else {
+			stream_ = &output;
+		}
+#else
+		stream_ = &output;
+#endif
+		own_buffer_.reserve(BUFFER_SIZE);
+	}
+
+	Sink::~Sink() {
+		try {
+			Flush();
+		}
+		catch (...) {
+		}
+	}
+
+	Sink& Sink::operator<<(std::string_view text) {
+		Write(text.data(), text.size());
+		return *this;
+	}
+
+	Sink& Sink::operator<<(char c) {
+		Write(&c, 1);
+		return *this;
+	}
+
+	Sink& Sink::operator<<(int value) {
+		char buffer[16];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		Write(buffer, result.ptr - buffer);
+		return *this;
+	}
+
+	Sink& Sink::operator<<(uint32_t value) {
+		char buffer[16];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		Write(buffer, result.ptr - buffer);
+		return *this;
+	}
+
+	Sink& Sink::operator<<(double value) {
+		char buffer[32];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+		Write(buffer, result.ptr - buffer);
+		return *this;
+	}
+
+	Sink& Sink::WriteRoundTrip(double value) {
+		char buffer[32];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		Write(buffer, result.ptr - buffer);
+		return *this;
+	}
+
+	void Sink::Flush() {
+		if (&buffer_ == &own_buffer_ && !buffer_.empty()) {
+			WriteOut(buffer_, {});
+			buffer_.clear();
+		}
+	}
+
+	void Sink::Write(const char* data, size_t size) {
+		if (&buffer_ != &own_buffer_ || buffer_.size() + size <= BUFFER_SIZE) {
+			buffer_.append(data, size);
+			return;
+		}
+		if (size < BUFFER_SIZE) {
+			Flush();
+			buffer_.append(data, size);
+			return;
+		}
+		WriteOut(buffer_, std::string_view(data, size));
+		buffer_.clear();
+	}
+
+	// Writes first and then second; to a descriptor both go out in one writev call.
+	void Sink::WriteOut(std::string_view first, std::string_view second) {
+		if (stream_) {
+			stream_->write(first.data(), first.size());
+			stream_->write(second.data(), second.size());
+			return;
+		}
+
+#ifdef OUTPUT_SINK_WRITEV
+		iovec parts[2] = {
+			{ const_cast<char*>(first.data()), first.size() },
+			{ const_cast<char*>(second.data()), second.size() }
+		};
+		iovec* part = parts;
+		int count = 2;
+		while (count > 0) {
+			const ssize_t written = writev(fd_, part, count);
+			if (written < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw std::system_error(errno, std::generic_category(), "write to stdout failed");
+			}
+			size_t left = static_cast<size_t>(written);
+			while (count > 0 && left >= part->iov_len) {
+				left -= part->iov_len;
+				++part;
+				--count;
+			}
+			if (count > 0) {
+				part->iov_base = static_cast<char*>(part->iov_base) + left;
+				part->iov_len -= left;
+			}
+		}
+#endif
+	}
+
+}
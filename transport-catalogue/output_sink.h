@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace io {
+
+	// Collects output in one contiguous buffer and passes it on in large pieces.
+	// Numbers are formatted in place with to_chars instead of going through iostream.
+	// On Unix output for std::cout is written to the stdout descriptor directly; appends
+	// larger than the buffer are written together with it by writev, without being copied.
+	// That bypasses the buffer of std::cout, so while such a Sink is alive nothing else may
+	// be written to std::cout: it could come out before text the sink still holds.
+	// Elsewhere every ostream, std::cout included, gets ostream::write.
+	class Sink {
+	public:
+		// Appends everything to output; nothing is flushed.
+		explicit Sink(std::string& output);
+		explicit Sink(std::ostream& output);
+
+		Sink(const Sink&) = delete;
+		Sink& operator=(const Sink&) = delete;
+
+		~Sink();
+
+		Sink& operator<<(std::string_view text);
+		Sink& operator<<(const std::string& text) {
+			return *this << std::string_view(text);
+		}
+		Sink& operator<<(char c);
+		Sink& operator<<(int value);
+		Sink& operator<<(uint32_t value);
+		// As an ostream with default flags prints it: %g with 6 significant digits.
+		Sink& operator<<(double value);
+
+		// The shortest text that reads back as exactly the same double.
+		Sink& WriteRoundTrip(double value);
+
+		void Flush();
+
+	private:
+		static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+		void Write(const char* data, size_t size);
+		void WriteOut(std::string_view first, std::string_view second);
+
+		std::string own_buffer_;
+		std::string& buffer_;
+		std::ostream* stream_ = nullptr;
+		int fd_ = -1;
+	};
+
+}
@@ -0,0 +1,476 @@
+#pragma once
+
+#include "geo.h"
+#include "graph.h"
+#include "parallel.h"
+
+#include "graph.pb.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Multi-level partition overlay router. Vertices are split geographically into nested cells
+    // (level 0 is the finest). Every cell stores the shortest in-cell distances between its boundary
+    // vertices, so a query expands original edges only near the source and the target and moves
+    // through the rest of the network over these cliques. Memory stays close to linear in the graph.
+    // BuildRoute reuses one search workspace between queries, so a router must not be queried from
+    // several threads at once. Cliques keep weights only: every shortcut on the found route is expanded
+    // by searching its cell again, which costs a cell search and its allocations per shortcut.
+    template <typename Weight>
+    class OverlayRouter {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        static constexpr size_t BITS_PER_LEVEL = 2;
+        static constexpr size_t DEFAULT_CELL_SIZE = 64;
+
+        OverlayRouter(const Graph& graph, const std::vector<geo::Coordinates>& positions, size_t max_cell_size = DEFAULT_CELL_SIZE);
+
+        std::shared_ptr<std::vector<size_t>> BuildRoute(VertexId from, VertexId to) const;
+
+        size_t GetLevelCount() const;
+
+        void Serialize(GraphProto::OverlayRouter& proto) const;
+        static std::unique_ptr<OverlayRouter> Deserialize(const GraphProto::OverlayRouter& proto, const Graph& graph);
+
+    private:
+        static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+        static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::max();
+        static constexpr Weight ZERO_WEIGHT{};
+
+        struct Cell {
+            std::vector<VertexId> nodes;
+            std::vector<VertexId> boundary;
+            std::vector<Weight> clique;
+        };
+
+        struct Level {
+            std::vector<Cell> cells;
+            std::vector<uint32_t> node_index;
+            std::vector<uint32_t> boundary_index;
+        };
+
+        // How a vertex was reached: by original edge (level == 0) or by a clique shortcut
+        // of the level - 1 cell containing prev.
+        struct Label {
+            VertexId prev = 0;
+            EdgeId edge = 0;
+            size_t level = 0;
+        };
+
+        OverlayRouter(const Graph& graph, size_t depth, std::vector<uint32_t> codes);
+
+        static void Bisect(const std::vector<geo::Coordinates>& positions, std::vector<VertexId>::iterator begin,
+            std::vector<VertexId>::iterator end, size_t depth_left, uint32_t code, std::vector<uint32_t>& codes);
+
+        uint32_t CellOf(size_t level, VertexId vertex) const {
+            return codes_[vertex] >> (level * BITS_PER_LEVEL);
+        }
+
+        size_t QueryLevel(VertexId vertex, VertexId from, VertexId to) const;
+
+        template <typename Visitor>
+        void ForEachArc(VertexId vertex, size_t scan_level, Visitor visit) const;
+
+        void BuildCells();
+        void Customize();
+        void CustomizeCell(size_t level, uint32_t cell_id);
+
+        void SearchCell(size_t level, uint32_t cell_id, VertexId source,
+            std::vector<Weight>& distance, std::vector<Label>* parents) const;
+        void Unpack(const Label& label, VertexId to, std::vector<size_t>& edges) const;
+
+        const Graph& graph_;
+        size_t depth_ = 0;
+        std::vector<uint32_t> codes_;
+        std::vector<Level> levels_;
+
+        mutable std::vector<Weight> distance_;
+        mutable std::vector<Label> parents_;
+        mutable std::vector<uint32_t> stamps_;
+        mutable uint32_t stamp_ = 0;
+    };
+
+
+    template <typename Weight>
+    OverlayRouter<Weight>::OverlayRouter(const Graph& graph, const std::vector<geo::Coordinates>& positions, size_t max_cell_size)
+        : graph_(graph)
+        , codes_(graph.GetVertexCount(), 0)
+    {
+        const size_t vertex_count = graph.GetVertexCount();
+        max_cell_size = std::max<size_t>(1, max_cell_size);
+        while (depth_ < 30 && (vertex_count >> depth_) > max_cell_size) {
+            ++depth_;
+        }
+
+        std::vector<VertexId> order(vertex_count);
+        std::iota(order.begin(), order.end(), 0);
+        Bisect(positions, order.begin(), order.end(), depth_, 0, codes_);
+
+        BuildCells();
+        Customize();
+    }
+
+    template <typename Weight>
+    OverlayRouter<Weight>::OverlayRouter(const Graph& graph, size_t depth, std::vector<uint32_t> codes)
+        : graph_(graph)
+        , depth_(depth)
+        , codes_(std::move(codes))
+    {
+        BuildCells();
+    }
+
+    template <typename Weight>
+    size_t OverlayRouter<Weight>::GetLevelCount() const {
+        return levels_.size();
+    }
+
+    template <typename Weight>
+    void OverlayRouter<Weight>::Bisect(const std::vector<geo::Coordinates>& positions, std::vector<VertexId>::iterator begin,
+        std::vector<VertexId>::iterator end, size_t depth_left, uint32_t code, std::vector<uint32_t>& codes) {
+        if (depth_left == 0) {
+            for (auto it = begin; it != end; ++it) {
+                codes[*it] = code;
+            }
+            return;
+        }
+
+        if (begin != end) {
+            const auto [min_lat, max_lat] = std::minmax_element(begin, end, [&positions](VertexId lhs, VertexId rhs) {
+                return positions[lhs].lat < positions[rhs].lat;
+                });
+            const auto [min_lng, max_lng] = std::minmax_element(begin, end, [&positions](VertexId lhs, VertexId rhs) {
+                return positions[lhs].lng < positions[rhs].lng;
+                });
+            const double lat_span = positions[*max_lat].lat - positions[*min_lat].lat;
+            const double lng_span = (positions[*max_lng].lng - positions[*min_lng].lng)
+                * std::cos(positions[*min_lat].lat * 3.1415926535 / 180.);
+
+            const bool by_lat = lat_span >= lng_span;
+            std::nth_element(begin, begin + (end - begin) / 2, end, [&positions, by_lat](VertexId lhs, VertexId rhs) {
+                const double l = by_lat ? positions[lhs].lat : positions[lhs].lng;
+                const double r = by_lat ? positions[rhs].lat : positions[rhs].lng;
+                return l < r || (l == r && lhs < rhs);
+                });
+        }
+
+        const auto middle = begin + (end - begin) / 2;
+        Bisect(positions, begin, middle, depth_left - 1, code << 1, codes);
+        Bisect(positions, middle, end, depth_left - 1, (code << 1) | 1, codes);
+    }
+
+    template <typename Weight>
+    void OverlayRouter<Weight>::BuildCells() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        const size_t level_count = (depth_ + BITS_PER_LEVEL - 1) / BITS_PER_LEVEL;
+
+        levels_.assign(level_count, Level{});
+        std::vector<bool> is_boundary(vertex_count);
+        std::vector<bool> was_boundary(vertex_count, true);
+
+        for (size_t level = 0; level < level_count; ++level) {
+            Level& data = levels_[level];
+            data.cells.resize(size_t{ 1 } << (depth_ - level * BITS_PER_LEVEL));
+            data.node_index.assign(vertex_count, NONE);
+            data.boundary_index.assign(vertex_count, NONE);
+
+            std::fill(is_boundary.begin(), is_boundary.end(), false);
+            for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (CellOf(level, edge.from) != CellOf(level, edge.to)) {
+                    is_boundary[edge.from] = true;
+                    is_boundary[edge.to] = true;
+                }
+            }
+
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                Cell& cell = data.cells[CellOf(level, vertex)];
+                if (was_boundary[vertex]) {
+                    data.node_index[vertex] = static_cast<uint32_t>(cell.nodes.size());
+                    cell.nodes.push_back(vertex);
+                }
+                if (is_boundary[vertex]) {
+                    data.boundary_index[vertex] = static_cast<uint32_t>(cell.boundary.size());
+                    cell.boundary.push_back(vertex);
+                }
+            }
+            was_boundary = is_boundary;
+        }
+    }
+
+    template <typename Weight>
+    template <typename Visitor>
+    void OverlayRouter<Weight>::ForEachArc(VertexId vertex, size_t scan_level, Visitor visit) const {
+        if (scan_level == 0) {
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                visit(edge.to, edge.weight, Label{ vertex, edge_id, 0 });
+            }
+            return;
+        }
+
+        const size_t sub_level = scan_level - 1;
+        const Level& level = levels_[sub_level];
+        const Cell& cell = level.cells[CellOf(sub_level, vertex)];
+        const size_t row = level.boundary_index[vertex];
+        const size_t width = cell.boundary.size();
+        for (size_t column = 0; column < width; ++column) {
+            const Weight weight = cell.clique[row * width + column];
+            if (column != row && weight != INFINITE_WEIGHT) {
+                visit(cell.boundary[column], weight, Label{ vertex, 0, scan_level });
+            }
+        }
+
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (CellOf(sub_level, edge.to) != CellOf(sub_level, vertex)) {
+                visit(edge.to, edge.weight, Label{ vertex, edge_id, 0 });
+            }
+        }
+    }
+
+    template <typename Weight>
+    void OverlayRouter<Weight>::SearchCell(size_t level, uint32_t cell_id, VertexId source,
+        std::vector<Weight>& distance, std::vector<Label>* parents) const {
+        const Level& data = levels_[level];
+        const Cell& cell = data.cells[cell_id];
+
+        distance.assign(cell.nodes.size(), INFINITE_WEIGHT);
+        if (parents) {
+            parents->assign(cell.nodes.size(), Label{});
+        }
+
+        using QueueItem = std::pair<Weight, uint32_t>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+        distance[data.node_index[source]] = ZERO_WEIGHT;
+        queue.push({ ZERO_WEIGHT, data.node_index[source] });
+
+        while (!queue.empty()) {
+            const auto [weight, local] = queue.top();
+            queue.pop();
+            if (weight != distance[local]) {
+                continue;
+            }
+
+            ForEachArc(cell.nodes[local], level, [&](VertexId to, Weight arc_weight, const Label& label) {
+                if (CellOf(level, to) != cell_id) {
+                    return;
+                }
+                const uint32_t to_local = data.node_index[to];
+                const Weight candidate = weight + arc_weight;
+                if (candidate < distance[to_local]) {
+                    distance[to_local] = candidate;
+                    if (parents) {
+                        (*parents)[to_local] = label;
+                    }
+                    queue.push({ candidate, to_local });
+                }
+            });
+        }
+    }
+
+    template <typename Weight>
+    void OverlayRouter<Weight>::CustomizeCell(size_t level, uint32_t cell_id) {
+        Level& data = levels_[level];
+        Cell& cell = data.cells[cell_id];
+        const size_t width = cell.boundary.size();
+
+        cell.clique.assign(width * width, INFINITE_WEIGHT);
+        std::vector<Weight> distance;
+        for (size_t row = 0; row < width; ++row) {
+            SearchCell(level, cell_id, cell.boundary[row], distance, nullptr);
+            for (size_t column = 0; column < width; ++column) {
+                cell.clique[row * width + column] = distance[data.node_index[cell.boundary[column]]];
+            }
+        }
+    }
+
+    template <typename Weight>
+    void OverlayRouter<Weight>::Customize() {
+        for (size_t level = 0; level < levels_.size(); ++level) {
+            parallel::ForEachIndex(levels_[level].cells.size(), [this, level](size_t cell_id) {
+                CustomizeCell(level, static_cast<uint32_t>(cell_id));
+            });
+        }
+    }
+
+    template <typename Weight>
+    size_t OverlayRouter<Weight>::QueryLevel(VertexId vertex, VertexId from, VertexId to) const {
+        for (size_t level = levels_.size(); level > 0; --level) {
+            const uint32_t cell = CellOf(level - 1, vertex);
+            if (cell != CellOf(level - 1, from) && cell != CellOf(level - 1, to)) {
+                return level;
+            }
+        }
+        return 0;
+    }
+
+    template <typename Weight>
+    void OverlayRouter<Weight>::Unpack(const Label& label, VertexId to, std::vector<size_t>& edges) const {
+        if (label.level == 0) {
+            edges.push_back(label.edge);
+            return;
+        }
+
+        const size_t level = label.level - 1;
+        const uint32_t cell_id = CellOf(level, label.prev);
+        const Level& data = levels_[level];
+
+        std::vector<Weight> distance;
+        std::vector<Label> parents;
+        SearchCell(level, cell_id, label.prev, distance, &parents);
+
+        std::vector<std::pair<Label, VertexId>> path;
+        for (VertexId vertex = to; vertex != label.prev;) {
+            const Label& step = parents[data.node_index[vertex]];
+            path.push_back({ step, vertex });
+            vertex = step.prev;
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            Unpack(it->first, it->second, edges);
+        }
+    }
+
+    template <typename Weight>
+    std::shared_ptr<std::vector<size_t>> OverlayRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (distance_.size() != vertex_count) {
+            distance_.assign(vertex_count, INFINITE_WEIGHT);
+            parents_.assign(vertex_count, Label{});
+            stamps_.assign(vertex_count, 0);
+            stamp_ = 0;
+        }
+        if (++stamp_ == 0) {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            stamp_ = 1;
+        }
+
+        auto distance = [this](VertexId vertex) {
+            return stamps_[vertex] == stamp_ ? distance_[vertex] : INFINITE_WEIGHT;
+        };
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+        stamps_[from] = stamp_;
+        distance_[from] = ZERO_WEIGHT;
+        queue.push({ ZERO_WEIGHT, from });
+
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight != distance(vertex)) {
+                continue;
+            }
+            if (vertex == to) {
+                break;
+            }
+
+            ForEachArc(vertex, QueryLevel(vertex, from, to), [&](VertexId next, Weight arc_weight, const Label& label) {
+                const Weight candidate = weight + arc_weight;
+                if (candidate < distance(next)) {
+                    stamps_[next] = stamp_;
+                    distance_[next] = candidate;
+                    parents_[next] = label;
+                    queue.push({ candidate, next });
+                }
+            });
+        }
+
+        if (distance(to) == INFINITE_WEIGHT) {
+            return nullptr;
+        }
+
+        std::vector<std::pair<Label, VertexId>> path;
+        for (VertexId vertex = to; vertex != from; vertex = parents_[vertex].prev) {
+            path.push_back({ parents_[vertex], vertex });
+        }
+
+        auto edges = std::make_shared<std::vector<size_t>>();
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            Unpack(it->first, it->second, *edges);
+        }
+        return edges;
+    }
+
+    template <typename Weight>
+    void OverlayRouter<Weight>::Serialize(GraphProto::OverlayRouter& proto) const {
+        proto.set_depth(depth_);
+        for (const uint32_t code : codes_) {
+            proto.add_cell_codes(code);
+        }
+
+        for (const Level& level : levels_) {
+            auto& level_proto = *proto.add_levels();
+            for (const Cell& cell : level.cells) {
+                auto& cell_proto = *level_proto.add_cells();
+                for (const Weight weight : cell.clique) {
+                    if constexpr (std::is_integral_v<Weight>) {
+                        cell_proto.add_fixed_clique(weight);
+                    }
+                    else {
+                        cell_proto.add_clique(weight);
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::unique_ptr<OverlayRouter<Weight>> OverlayRouter<Weight>::Deserialize(const GraphProto::OverlayRouter& proto, const Graph& graph) {
+        // The cells are rebuilt from the codes, so the codes have to fit the graph and the
+        // saved levels and cliques the cells built from them.
+        const size_t depth = proto.depth();
+        if (depth > 30 || static_cast<size_t>(proto.cell_codes_size()) != graph.GetVertexCount()) {
+            throw std::runtime_error("invalid serialized overlay router");
+        }
+        std::vector<uint32_t> codes(proto.cell_codes().begin(), proto.cell_codes().end());
+        for (const uint32_t code : codes) {
+            if ((code >> depth) != 0) {
+                throw std::runtime_error("invalid serialized overlay router");
+            }
+        }
+        std::unique_ptr<OverlayRouter> router(new OverlayRouter(graph, depth, std::move(codes)));
+
+        if (static_cast<size_t>(proto.levels_size()) != router->levels_.size()) {
+            throw std::runtime_error("overlay levels mismatch");
+        }
+        for (size_t level = 0; level < router->levels_.size(); ++level) {
+            auto& cells = router->levels_[level].cells;
+            const auto& level_proto = proto.levels(level);
+            if (static_cast<size_t>(level_proto.cells_size()) != cells.size()) {
+                throw std::runtime_error("overlay cells mismatch");
+            }
+            for (size_t cell_id = 0; cell_id < cells.size(); ++cell_id) {
+                const auto& cell_proto = level_proto.cells(cell_id);
+                const size_t width = cells[cell_id].boundary.size();
+                const int clique_size = std::is_integral_v<Weight> ? cell_proto.fixed_clique_size() : cell_proto.clique_size();
+                if (static_cast<size_t>(clique_size) != width * width) {
+                    throw std::runtime_error("overlay clique mismatch");
+                }
+                if constexpr (std::is_integral_v<Weight>) {
+                    for (const auto weight : cell_proto.fixed_clique()) {
+                        cells[cell_id].clique.push_back(static_cast<Weight>(weight));
+                    }
+                }
+                else {
+                    cells[cell_id].clique.assign(cell_proto.clique().begin(), cell_proto.clique().end());
+                }
+            }
+        }
+        return router;
+    }
+}
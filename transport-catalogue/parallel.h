@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+    inline size_t WorkerCount(size_t task_count) {
+        const size_t hardware = std::max<size_t>(1, std::thread::hardware_concurrency());
+        return std::max<size_t>(1, std::min(hardware, task_count));
+    }
+
+    // Calls func(index) for every index in [0, count), splitting the range into
+    // contiguous blocks, one per worker. The first exception thrown is rethrown.
+    template <typename Func>
+    void ForEachIndex(size_t count, Func func) {
+        const size_t workers = WorkerCount(count);
+        if (workers < 2) {
+            for (size_t index = 0; index < count; ++index) {
+                func(index);
+            }
+            return;
+        }
+
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        std::vector<std::thread> threads;
+        threads.reserve(workers);
+
+        const size_t block = (count + workers - 1) / workers;
+        for (size_t begin = 0; begin < count; begin += block) {
+            const size_t end = std::min(count, begin + block);
+            threads.emplace_back([&func, &error, &error_mutex, begin, end] {
+                try {
+                    for (size_t index = begin; index < end; ++index) {
+                        func(index);
+                    }
+                }
+                catch (...) {
+                    std::lock_guard guard(error_mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+}
@@ -1,4 +1,5 @@
 #include "request_handler.h"
+#include "json_binding.h"
 
 
 namespace transport::response {
@@ -7,156 +8,258 @@ namespace transport::response {
 	using namespace transport::router;
 	using namespace std::literals;
 
+	namespace {
 
-	RequestHelper::RequestHelper(TransportCatalogue& tc, const json::Array& stat_requests)
-		: catalogue_(tc)
-	{
-		requests_.reserve(stat_requests.size());
-		for (const json::Node& n : stat_requests) {
-			Request request;
-			const auto &node_map =  n.AsMap();
-			request.id = node_map.at("id"s).AsInt();
+		using json::binding::Required;
+		using json::binding::Optional;
 
-			std::string type = node_map.at("type"s).AsString();
-			if (type == "Stop"s) {
-				request.name = node_map.at("name"s).AsString();
-				request.type = RequestType::STOP;
-			}
-			else if (type == "Bus"s) {
-				request.name = node_map.at("name"s).AsString();
-				request.type = RequestType::BUS;
-			}
-			else if (type == "Map"s) {
-				request.type = RequestType::MAP;
-			}
-			else if (type == "Route"s) {
-				request.from = node_map.at("from"s).AsString();
-				request.to = node_map.at("to"s).AsString();
-				request.type = RequestType::ROUTER;
-			}
-			else {
-				throw json::ParsingError("Request invalid"s);
-			}
-			requests_.push_back(request);
-		}
-	}
+		constexpr auto COORDINATES_SCHEMA = json::binding::MakeSchema<geo::Coordinates>(
+			Required("latitude"sv, &geo::Coordinates::lat),
+			Required("longitude"sv, &geo::Coordinates::lng)
+		);
 
-	void RequestHelper::GetResponses() {
-		for (const Request& request : requests_) {
-			switch (request.type) {
-			case RequestType::STOP: {
-				if (auto stop_info = catalogue_.GetStopInfo(request.name); stop_info) {
-					responses_.push_back(CreateJsonResponseStop(request.id, *stop_info));
+		// Readers are generic so that one schema serves json::Node and json::flat::Node.
+		constexpr auto REQUEST_SCHEMA = json::binding::MakeSchema<Request>(
+			Required("id"sv, &Request::id),
+			Required("type"sv, &Request::type, [](RequestType& type, const auto& node) {
+				const std::string_view name = node.AsString();
+				if (name == "Stop"sv) {
+					type = RequestType::STOP;
 				}
-				else {
-					responses_.push_back(CreateJsonResponseError(request.id));
+				else if (name == "Bus"sv) {
+					type = RequestType::BUS;
+				}
+				else if (name == "Map"sv) {
+					type = RequestType::MAP;
 				}
-			} break;
-			case RequestType::BUS: {
-				if (auto route_info = catalogue_.GetBusInfo(request.name); route_info) {
-					responses_.push_back(CreateJsonResponseBus(request.id, *route_info));
+				else if (name == "Route"sv) {
+					type = RequestType::ROUTER;
 				}
 				else {
-					responses_.push_back(CreateJsonResponseError(request.id));
+					throw json::ParsingError("Request invalid"s);
 				}
-			} break;
-			case RequestType::MAP: {
-				responses_.push_back(CreateJsonResponseMap(request.id, catalogue_.GetMap()));
-			} break;
-			case RequestType::ROUTER: {
-				if (auto graph_router = catalogue_.findRouteInBase(request.from, request.to); graph_router) {
-					responses_.push_back(CreateJsonResponseRoute(request.id, graph_router).AsMap());
+			}),
+			Optional("name"sv, &Request::name),
+			Optional("from"sv, &Request::from),
+			Optional("to"sv, &Request::to),
+			Optional("from_coords"sv, &Request::from_coords, [](std::optional<geo::Coordinates>& coordinates, const auto& node) {
+				COORDINATES_SCHEMA.Read(node.AsMap(), coordinates.emplace());
+			}),
+			Optional("to_coords"sv, &Request::to_coords, [](std::optional<geo::Coordinates>& coordinates, const auto& node) {
+				COORDINATES_SCHEMA.Read(node.AsMap(), coordinates.emplace());
+			}),
+			Optional("via"sv, &Request::via, [](std::vector<std::string>& via, const auto& node) {
+				for (const auto& stop : node.AsArray()) {
+					via.emplace_back(stop.AsString());
 				}
-				else {
-					responses_.push_back(CreateJsonResponseError(request.id));
+			}),
+			Optional("mode"sv, &Request::mode, [](RouteMode& mode, const auto& node) {
+				const std::string_view name = node.AsString();
+				if (name == "fewest_transfers"sv) {
+					mode = RouteMode::FEWEST_TRANSFERS;
+				}
+				else if (name != "time"sv) {
+					throw json::ParsingError("Request invalid"s);
 				}
+			})
+		);
+
+		constexpr uint64_t NAME_FIELD = REQUEST_SCHEMA.Bit("name"sv);
+		constexpr uint64_t FROM_FIELD = REQUEST_SCHEMA.Bit("from"sv);
+		constexpr uint64_t TO_FIELD = REQUEST_SCHEMA.Bit("to"sv);
+
+		// Shared by json::Node and json::flat::Node, which expose the same reading interface.
+		template <typename NodeType>
+		Request ParseRequestNode(const NodeType& node) {
+			Request request;
+			const uint64_t fields = REQUEST_SCHEMA.Read(node.AsMap(), request);
 
-			} break;
+			switch (request.type) {
+			case RequestType::STOP:
+			case RequestType::BUS:
+				if (!(fields & NAME_FIELD)) {
+					throw json::ParsingError("Request invalid"s);
+				}
+				break;
+			case RequestType::ROUTER:
+				if ((!request.from_coords && !(fields & FROM_FIELD)) || (!request.to_coords && !(fields & TO_FIELD))) {
+					throw json::ParsingError("Request invalid"s);
+				}
+				if ((request.from_coords || request.to_coords) && (!request.via.empty() || request.mode != RouteMode::TIME)) {
+					throw json::ParsingError("Request invalid"s);
+				}
+				break;
 			default:
-				throw std::logic_error("unknown type");
+				break;
 			}
+			return request;
 		}
 
 	}
 
 
-	void RequestHelper::PrintResponse(std::ostream& out) {
-		json::Print(json::Document{ responses_ }, out);
+	RequestHelper::RequestHelper(TransportCatalogue& tc)
+		: catalogue_(tc) {}
+
+	RequestHelper::RequestHelper(TransportCatalogue& tc, const json::Array& stat_requests)
+		: catalogue_(tc)
+	{
+		requests_.reserve(stat_requests.size());
+		for (const json::Node& n : stat_requests) {
+			requests_.push_back(ParseRequest(n));
+		}
+	}
+
+	RequestHelper::RequestHelper(TransportCatalogue& tc, json::flat::Array stat_requests)
+		: catalogue_(tc)
+	{
+		requests_.reserve(stat_requests.size());
+		for (const json::flat::Node& n : stat_requests) {
+			requests_.push_back(ParseRequest(n));
+		}
 	}
 
-	json::Node RequestHelper::CreateJsonResponseError(const int request_id) {
-		return json::Builder{}.
-			StartDict().
-			Key("request_id"s).Value(request_id).
-			Key("error_message"s).Value("not found"s).
-			EndDict().
-			Build();
+	Request RequestHelper::ParseRequest(const json::Node& node) {
+		return ParseRequestNode(node);
 	}
 
+	Request RequestHelper::ParseRequest(const json::flat::Node& node) {
+		return ParseRequestNode(node);
+	}
 
-	json::Node RequestHelper::CreateJsonResponseStop(const int request_id, const domains::Stop& data) {
-		json::Builder builder;
-		builder.StartArray();
-		for (auto& bus : data.buses) {
-			builder.Value(bus);
+	void RequestHelper::GetResponses() {
+		json::Writer writer(responses_);
+		writer.BeginArray();
+		for (const Request& request : requests_) {
+			Respond(request, writer);
 		}
-		json::Node tmp = builder.EndArray().Build();
-		return json::Builder{}.
-			StartDict().
-			Key("request_id"s).Value(request_id).
-			Key("buses").Value(tmp.AsArray()).
-			EndDict().
-			Build();
+		writer.EndArray();
 	}
 
-	json::Node RequestHelper::CreateJsonResponseBus(const int request_id, const domains::Bus data) {
-		return json::Builder{}.
-			StartDict().
-			Key("request_id"s).Value(request_id).
-			Key("route_length"s).Value(data.route_length).
-			Key("stop_count"s).Value(data.stop_count).
-			Key("unique_stop_count"s).Value(data.unique_stop_count).
-			Key("curvature"s).Value(data.curvature).
-			EndDict().
-			Build();
+	void RequestHelper::Respond(const Request& request, json::Writer& writer) {
+		switch (request.type) {
+		case RequestType::STOP: {
+			if (const auto stop = catalogue_.GetStopInfo(request.name)) {
+				WriteResponseStop(writer, request.id, *stop);
+			}
+			else {
+				WriteResponseError(writer, request.id);
+			}
+		} break;
+		case RequestType::BUS: {
+			if (const auto bus = catalogue_.GetBusInfo(request.name)) {
+				WriteResponseBus(writer, request.id, *bus);
+			}
+			else {
+				WriteResponseError(writer, request.id);
+			}
+		} break;
+		case RequestType::MAP: {
+			WriteResponseMap(writer, request.id, catalogue_.GetMapJson());
+		} break;
+		case RequestType::ROUTER: {
+			std::shared_ptr<std::vector<RouteItem>> graph_router;
+			if (request.from_coords || request.to_coords) {
+				RoutePoint from = request.from;
+				RoutePoint to = request.to;
+				if (request.from_coords) from = *request.from_coords;
+				if (request.to_coords) to = *request.to_coords;
+				graph_router = catalogue_.findRouteInBase(from, to);
+			}
+			else if (request.via.empty() && request.mode == RouteMode::TIME) {
+				graph_router = catalogue_.findRouteInBase(std::string_view{ request.from }, std::string_view{ request.to });
+			}
+			else {
+				std::vector<std::string_view> waypoints{ request.from };
+				waypoints.insert(waypoints.end(), request.via.begin(), request.via.end());
+				waypoints.push_back(request.to);
+				graph_router = catalogue_.findRouteInBase(waypoints, request.mode);
+			}
+
+			if (graph_router) {
+				WriteResponseRoute(writer, request.id, *graph_router);
+			}
+			else {
+				WriteResponseError(writer, request.id);
+			}
+
+		} break;
+		default:
+			throw std::logic_error("unknown type");
+		}
+	}
+
+
+	void RequestHelper::PrintResponse(std::ostream& out) {
+		io::Sink(out) << responses_;
 	}
 
-	json::Node RequestHelper::CreateJsonResponseMap(const int request_id, const std::string map_render_data) {
-		return json::Builder{}.
-			StartDict().
-			Key("map"s).Value(map_render_data).
-			Key("request_id"s).Value(request_id).
-			EndDict().
-			Build();
+	// Keys are written in sorted order, as json::Dict used to print them.
+
+	void RequestHelper::WriteResponseError(json::Writer& writer, const int request_id) {
+		writer.BeginDict()
+			.Key("error_message"sv).Value("not found"sv)
+			.Key("request_id"sv).Value(request_id)
+			.EndDict();
 	}
 
-	json::Node RequestHelper::CreateJsonResponseRoute(const int request_id, std::shared_ptr<std::vector<RouteItem>> route) {
+	void RequestHelper::WriteResponseStop(json::Writer& writer, const int request_id, const StopView& data) {
+		writer.BeginDict().Key("buses"sv).BeginArray();
+		for (size_t i = 0; i < data.GetBusCount(); ++i) {
+			writer.Value(data.GetBusName(i));
+		}
+		writer.EndArray()
+			.Key("request_id"sv).Value(request_id)
+			.EndDict();
+	}
+
+	void RequestHelper::WriteResponseBus(json::Writer& writer, const int request_id, const BusView& data) {
+		writer.BeginDict()
+			.Key("curvature"sv).Value(data.curvature)
+			.Key("request_id"sv).Value(request_id)
+			.Key("route_length"sv).Value(data.route_length)
+			.Key("stop_count"sv).Value(data.stop_count)
+			.Key("unique_stop_count"sv).Value(data.unique_stop_count)
+			.EndDict();
+	}
 
-		json::Builder builder_;
-		builder_.StartArray();
+	void RequestHelper::WriteResponseMap(json::Writer& writer, const int request_id, const std::string& map_json) {
+		writer.BeginDict()
+			.Key("map"sv).Raw(map_json)
+			.Key("request_id"sv).Value(request_id)
+			.EndDict();
+	}
+
+	void RequestHelper::WriteResponseRoute(json::Writer& writer, const int request_id, const std::vector<RouteItem>& route) {
+		writer.BeginDict().Key("items"sv).BeginArray();
 		double total_time = 0.0;
-		for (auto it = route->begin(); it != route->end(); it++) {
-			total_time += (it->wait_time + it->trip_time);
-			builder_.StartDict()
-				.Key("type"s).Value("Wait"s)
-				.Key("stop_name"s).Value(it->start_stop_idx->name)
-				.Key("time"s).Value(it->wait_time / 60)
+		for (const RouteItem& item : route) {
+			total_time += (item.wait_time + item.trip_time);
+			if (item.IsWalk()) {
+				writer.BeginDict();
+				if (item.start_stop_idx != NO_ID) writer.Key("from"sv).Value(catalogue_.GetStop(item.start_stop_idx).name);
+				writer.Key("time"sv).Value(item.trip_time / 60);
+				if (item.finish_stop_idx != NO_ID) writer.Key("to"sv).Value(catalogue_.GetStop(item.finish_stop_idx).name);
+				writer.Key("type"sv).Value("Walk"sv).EndDict();
+				continue;
+			}
+
+			writer.BeginDict()
+				.Key("stop_name"sv).Value(catalogue_.GetStop(item.start_stop_idx).name)
+				.Key("time"sv).Value(item.wait_time / 60)
+				.Key("type"sv).Value("Wait"sv)
 				.EndDict()
 
-				.StartDict()
-				.Key("type"s).Value("Bus"s)
-				.Key("bus"s).Value(it->bus->name)
-				.Key("span_count"s).Value(it->stop_count)
-				.Key("time"s).Value(it->trip_time / 60)
+				.BeginDict()
+				.Key("bus"sv).Value(catalogue_.GetBus(item.bus).name)
+				.Key("span_count"sv).Value(item.stop_count)
+				.Key("time"sv).Value(item.trip_time / 60)
+				.Key("type"sv).Value("Bus"sv)
 				.EndDict();
 		}
-		json::Node x = builder_.EndArray().Build();
-
-		return json::Builder{}
-			.StartDict()
-			.Key("request_id"s).Value(request_id)
-			.Key("total_time"s).Value(total_time / 60)
-			.Key("items"s).Value(x.AsArray())
-			.EndDict().Build();
+		writer.EndArray()
+			.Key("request_id"sv).Value(request_id)
+			.Key("total_time"sv).Value(total_time / 60)
+			.EndDict();
 	}
-}
+}
\ No newline at end of file
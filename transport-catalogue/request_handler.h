@@ -1,10 +1,13 @@
 #pragma once
 
 #include "json.h"
+#include "json_flat.h"
 #include "json_builder.h"
+#include "json_writer.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
+#include <optional>
 #include <string>
 #include <vector>
 #include <variant>
@@ -27,32 +30,45 @@ namespace transport::response {
 		std::string name = ""s;
 		std::string from = ""s;
 		std::string to = ""s;
+		std::optional<geo::Coordinates> from_coords;
+		std::optional<geo::Coordinates> to_coords;
+		std::vector<std::string> via;
+		RouteMode mode = RouteMode::TIME;
 		RequestType type;
 	};
 
 
 	class RequestHelper {
 	public:
+		explicit RequestHelper(TransportCatalogue& tc);
 		RequestHelper(TransportCatalogue& tc, const json::Array& stat_requests);
+		RequestHelper(TransportCatalogue& tc, json::flat::Array stat_requests);
 
 		void GetResponses();
 
 		void PrintResponse(std::ostream& out);
 
+		static Request ParseRequest(const json::Node& node);
+		static Request ParseRequest(const json::flat::Node& node);
+
+		// Answers a single request without keeping it, for streamed input.
+		void Respond(const Request& request, json::Writer& writer);
+
 	private:
 		TransportCatalogue& catalogue_;
 		std::vector<Request> requests_;
-		json::Array responses_;
+		std::string responses_;
 
-		json::Node CreateJsonResponseError(const int request_id);
+		void WriteResponseError(json::Writer& writer, const int request_id);
 
-		json::Node CreateJsonResponseStop(const int request_id, const domains::Stop& data);
+		void WriteResponseStop(json::Writer& writer, const int request_id, const StopView& data);
 
-		json::Node CreateJsonResponseBus(const int request_id, const domains::Bus data);
+		void WriteResponseBus(json::Writer& writer, const int request_id, const BusView& data);
 
-		json::Node CreateJsonResponseMap(const int request_id, const std::string map_render_data);
+		// map_json is the map already written as a JSON string.
+		void WriteResponseMap(json::Writer& writer, const int request_id, const std::string& map_json);
 
-		json::Node CreateJsonResponseRoute(const int request_id, std::shared_ptr<std::vector<RouteItem>> route);
+		void WriteResponseRoute(json::Writer& writer, const int request_id, const std::vector<RouteItem>& route);
 	};
 
 }
\ No newline at end of file
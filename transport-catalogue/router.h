@@ -8,8 +8,10 @@
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -38,25 +40,33 @@ namespace graph {
 
         Router(const Graph& graph, const GraphProto::Router& proto);
 
+        static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+        // Sentinels instead of optionals: with 32-bit weights an entry is 8 bytes.
         struct RouteInternalData {
-            Weight weight;
-            std::optional<EdgeId> prev_edge;
+            Weight weight = UNREACHABLE;
+            EdgeId prev_edge = NO_EDGE;
+
+            bool Exists() const {
+                return weight != UNREACHABLE;
+            }
         };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+        using RoutesInternalData = std::vector<std::vector<RouteInternalData>>;
 
 
 
         void InitializeRoutesInternalData(const Graph& graph) {
             const size_t vertex_count = graph.GetVertexCount();
             for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+                routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, NO_EDGE };
                 for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                     const auto& edge = graph.GetEdge(edge_id);
-                    if (edge.weight < ZERO_WEIGHT) {
-                        throw std::domain_error("Edges' weights should be non-negative");
+                    if (edge.weight < ZERO_WEIGHT || edge.weight >= UNREACHABLE) {
+                        throw std::domain_error("Edges' weights should be non-negative and finite");
                     }
                     auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                    if (!route_internal_data || route_internal_data->weight > edge.weight) {
+                    if (route_internal_data.weight > edge.weight) {
                         route_internal_data = RouteInternalData{ edge.weight, edge_id };
                     }
                 }
@@ -64,21 +74,25 @@ namespace graph {
         }
 
         void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from, const RouteInternalData& route_to) {
+            // A sum that would reach the sentinel is no route.
+            if (route_to.weight >= UNREACHABLE - route_from.weight) {
+                return;
+            }
             auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
             const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+            if (candidate_weight < route_relaxing.weight) {
                 route_relaxing = { candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge
+                                  route_to.prev_edge != NO_EDGE ? route_to.prev_edge : route_from.prev_edge
                 };
             }
         }
 
         void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
             for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
+                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]; route_from.Exists()) {
                     for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]; route_to.Exists()) {
+                            RelaxRoute(vertex_from, vertex_to, route_from, route_to);
                         }
                     }
                 }
@@ -95,7 +109,7 @@ namespace graph {
     Router<Weight>::Router(const Graph& graph)
         : graph_(graph)
         , routes_internal_data_(graph.GetVertexCount(),
-            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+            std::vector<RouteInternalData>(graph.GetVertexCount()))
     {
         InitializeRoutesInternalData(graph);
 
@@ -108,16 +122,16 @@ namespace graph {
     template <typename Weight>
     std::shared_ptr<std::vector<size_t>> Router<Weight>::BuildRoute(VertexId from, VertexId to) const {
         const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-        if (!route_internal_data) {
+        if (!route_internal_data.Exists()) {
             return nullptr;
         }
 
         std::shared_ptr<std::vector<size_t>> edges = std::make_shared<std::vector<size_t>>();
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-            edge_id;
-            edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+        for (EdgeId edge_id = route_internal_data.prev_edge;
+            edge_id != NO_EDGE;
+            edge_id = routes_internal_data_[from][graph_.GetEdge(edge_id).from].prev_edge)
         {
-            edges->push_back(*edge_id);
+            edges->push_back(edge_id);
         }
         std::reverse(edges->begin(), edges->end());
 
@@ -134,13 +148,18 @@ namespace graph {
             for (const auto& route_data : internal_data) {
                 auto& route_data_proto = *internal_data_proto.add_route();
 
-                if (route_data) {
+                if (route_data.Exists()) {
                     route_data_proto.set_exists(true);
-                    route_data_proto.set_weight(route_data->weight);
+                    if constexpr (std::is_integral_v<Weight>) {
+                        route_data_proto.set_fixed_weight(route_data.weight);
+                    }
+                    else {
+                        route_data_proto.set_weight(route_data.weight);
+                    }
 
-                    if (route_data->prev_edge) {
+                    if (route_data.prev_edge != NO_EDGE) {
                         route_data_proto.set_has_prev_edge(true);
-                        route_data_proto.set_prev_edge(*route_data->prev_edge);
+                        route_data_proto.set_prev_edge(route_data.prev_edge);
                     }
                 }
             }
@@ -161,10 +180,15 @@ namespace graph {
                 auto& route_data = internal_data.emplace_back();
 
                 if (route_data_proto.exists()) {
-                    route_data = RouteInternalData{ route_data_proto.weight(), std::nullopt };
+                    if constexpr (std::is_integral_v<Weight>) {
+                        route_data.weight = static_cast<Weight>(route_data_proto.fixed_weight());
+                    }
+                    else {
+                        route_data.weight = route_data_proto.weight();
+                    }
 
                     if (route_data_proto.has_prev_edge()) {
-                        route_data->prev_edge = route_data_proto.prev_edge();
+                        route_data.prev_edge = static_cast<EdgeId>(route_data_proto.prev_edge());
                     }
                 }
             }
@@ -0,0 +1,496 @@
+#include "graph.h"
+#include "overlay_router.h"
+#include "geo_index.h"
+#include "router.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Checks the overlay router against the all-pairs table on random graphs, the transport router's
+// multi-leg routes against their legs and its fewest-transfers and coordinate routes against routes
+// worked out by hand.
+namespace {
+
+	int failures = 0;
+
+	void Check(bool condition, string_view what, int line) {
+		if (!condition) {
+			cerr << "router_test.cpp:"sv << line << ": "sv << what << endl;
+			++failures;
+		}
+	}
+
+	using Weight = uint32_t;
+	using Graph = graph::DirectedWeightedGraph<Weight>;
+
+	// The weight of a route, or nothing when its edges do not lead from one vertex to the other.
+	optional<Weight> RouteWeight(const Graph& graph, graph::VertexId from, graph::VertexId to, const vector<size_t>& edges) {
+		Weight weight = 0;
+		graph::VertexId vertex = from;
+		for (const size_t edge_id : edges) {
+			const auto& edge = graph.GetEdge(static_cast<graph::EdgeId>(edge_id));
+			if (edge.from != vertex) {
+				return nullopt;
+			}
+			weight += edge.weight;
+			vertex = edge.to;
+		}
+		if (vertex != to) {
+			return nullopt;
+		}
+		return weight;
+	}
+
+	// Sparse graphs with a few long edges, parallel edges, loops and zero weights, so some pairs
+	// are unreachable and shortest routes cross cells on every level.
+	Graph MakeGraph(size_t vertex_count, size_t edge_count, mt19937& random) {
+		uniform_int_distribution<graph::VertexId> vertex_pick(0, static_cast<graph::VertexId>(vertex_count - 1));
+		uniform_int_distribution<Weight> weight(0, 1000);
+		Graph graph(vertex_count);
+		for (size_t i = 0; i < edge_count; ++i) {
+			const graph::VertexId from = vertex_pick(random);
+			const graph::VertexId to = i % 8 == 0 ? vertex_pick(random)
+				: static_cast<graph::VertexId>((from + 1 + random() % 5) % vertex_count);
+			graph.AddEdge({ from, to, weight(random) });
+		}
+		return graph;
+	}
+
+	void CompareRouters(const Graph& graph, const graph::Router<Weight>& table, const graph::OverlayRouter<Weight>& overlay, const string& what) {
+		const graph::VertexId vertex_count = static_cast<graph::VertexId>(graph.GetVertexCount());
+		for (graph::VertexId from = 0; from < vertex_count; ++from) {
+			for (graph::VertexId to = 0; to < vertex_count; ++to) {
+				const auto expected = table.BuildRoute(from, to);
+				const auto route = overlay.BuildRoute(from, to);
+				const string pair = what + ", " + to_string(from) + " -> " + to_string(to);
+				Check((expected == nullptr) == (route == nullptr), pair + ": same reachability", __LINE__);
+				if (expected == nullptr || route == nullptr) {
+					continue;
+				}
+				const auto weight = RouteWeight(graph, from, to, *route);
+				Check(weight.has_value(), pair + ": overlay edges form a route", __LINE__);
+				Check(weight == RouteWeight(graph, from, to, *expected), pair + ": same weight", __LINE__);
+			}
+		}
+	}
+
+	void TestOverlay() {
+		mt19937 random(28);
+		uniform_real_distribution<double> latitude(55.5, 55.9);
+		uniform_real_distribution<double> longitude(37.3, 37.9);
+
+		for (const size_t vertex_count : { 1, 2, 17, 60, 150 }) {
+			for (const size_t cell_size : { 1, 3, 8, 64 }) {
+				const Graph graph = MakeGraph(vertex_count, vertex_count * 2, random);
+				vector<geo::Coordinates> positions(vertex_count);
+				for (auto& position : positions) {
+					position = { latitude(random), longitude(random) };
+				}
+
+				const string what = to_string(vertex_count) + " vertexes, cells of " + to_string(cell_size);
+				const graph::Router<Weight> table(graph);
+				const graph::OverlayRouter<Weight> overlay(graph, positions, cell_size);
+				CompareRouters(graph, table, overlay, what);
+
+				GraphProto::OverlayRouter proto;
+				overlay.Serialize(proto);
+				CompareRouters(graph, table, *graph::OverlayRouter<Weight>::Deserialize(proto, graph), what + ", deserialized");
+			}
+		}
+	}
+
+	using transport::domains::StopId;
+	using transport::router::RouteItem;
+	using transport::router::RouteMode;
+	using transport::router::RoutingEngine;
+	using transport::router::RoutingSettings;
+	using transport::router::TransportRouter;
+
+	// Stops, buses and road distances as the catalogue hands them to the router.
+	struct Network {
+		vector<transport::domains::Stop> stops;
+		vector<transport::domains::Bus> buses;
+		transport::domains::RoadDistances distances;
+
+		StopId AddStop(double lat, double lng) {
+			stops.emplace_back().coordinates = { lat, lng };
+			return static_cast<StopId>(stops.size() - 1);
+		}
+
+		// A roundtrip bus lists its first stop again at the end.
+		void AddBus(bool is_roundtrip, vector<StopId> bus_stops) {
+			const auto id = static_cast<transport::domains::BusId>(buses.size());
+			for (const StopId stop : set<StopId>(bus_stops.begin(), bus_stops.end())) {
+				stops[stop].buses.push_back(id);
+			}
+			auto& bus = buses.emplace_back();
+			bus.is_roundtrip = is_roundtrip;
+			bus.stops = std::move(bus_stops);
+		}
+
+		// The reverse direction gets the same distance unless it has its own.
+		void SetDistance(StopId from, StopId to, int distance) {
+			distances.Set(from, to, distance);
+			distances.SetIfMissing(to, from, distance);
+		}
+	};
+
+	// A walk from or to a position has x for its stop. Times of walks measured on the sphere
+	// can be rounded to whole seconds for comparing with figures worked out by hand.
+	string Describe(const shared_ptr<vector<RouteItem>>& route, bool whole_seconds = false) {
+		if (route == nullptr) {
+			return "no route";
+		}
+		auto stop = [](StopId id) {
+			return id == transport::domains::NO_ID ? "x"s : to_string(id);
+		};
+		auto time = [whole_seconds](double seconds) {
+			return whole_seconds ? to_string(llround(seconds)) : to_string(seconds);
+		};
+		string text;
+		for (const RouteItem& item : *route) {
+			text += (item.IsWalk() ? "walk "s : "bus " + to_string(item.bus) + " ") + stop(item.start_stop_idx) + "->"
+				+ stop(item.finish_stop_idx) + " stops " + to_string(item.stop_count) + " trip " + time(item.trip_time)
+				+ " wait " + time(item.wait_time) + "; ";
+		}
+		return text;
+	}
+
+	Network MakeNetwork(size_t stop_count, size_t bus_count, mt19937& random) {
+		uniform_real_distribution<double> latitude(55.70, 55.75);
+		uniform_real_distribution<double> longitude(37.55, 37.65);
+		uniform_int_distribution<StopId> stop_pick(0, static_cast<StopId>(stop_count - 1));
+		uniform_int_distribution<int> distance(300, 3000);
+
+		Network network;
+		for (size_t i = 0; i < stop_count; ++i) {
+			network.AddStop(latitude(random), longitude(random));
+		}
+		for (size_t i = 0; i < bus_count; ++i) {
+			vector<StopId> stops;
+			for (size_t j = 0; j < 5; ++j) {
+				stops.push_back(stop_pick(random));
+			}
+			const bool is_roundtrip = i % 2 == 0;
+			if (is_roundtrip) {
+				stops.push_back(stops.front());
+			}
+			for (size_t j = 1; j < stops.size(); ++j) {
+				network.SetDistance(stops[j - 1], stops[j], distance(random));
+			}
+			network.AddBus(is_roundtrip, std::move(stops));
+		}
+		return network;
+	}
+
+	// On the heap: the built router refers to its own graph, so it cannot be moved.
+	unique_ptr<TransportRouter> MakeRouter(const Network& network, double walk_radius = 0.0) {
+		RoutingSettings settings(6, 36);
+		settings.walk_radius = walk_radius;
+		auto router = make_unique<TransportRouter>(network.stops, network.buses, network.distances, settings);
+		router->BuildGraph();
+		return router;
+	}
+
+	shared_ptr<vector<RouteItem>> FewestTransfers(TransportRouter& router, StopId from, StopId to) {
+		return router.findRoute({ from, to }, RouteMode::FEWEST_TRANSFERS);
+	}
+
+	size_t CountBuses(const vector<RouteItem>& route) {
+		return count_if(route.begin(), route.end(), [](const RouteItem& item) {
+			return !item.IsWalk();
+		});
+	}
+
+	double TotalTime(const vector<RouteItem>& route) {
+		double time = 0.0;
+		for (const RouteItem& item : route) {
+			time += item.trip_time + item.wait_time;
+		}
+		return time;
+	}
+
+	// Buses go 10 m/s and wait 360 s, people walk 5 km/h.
+	void TestFewestTransfers() {
+		{
+			// Never more buses than the fastest route and never faster than it. The fastest route
+			// is found on weights rounded to 0.1 s, so either route may be off by half of that on every item.
+			mt19937 random(30);
+			const Network network = MakeNetwork(60, 25, random);
+			uniform_int_distribution<StopId> stop_pick(0, static_cast<StopId>(network.stops.size() - 1));
+			const auto router = MakeRouter(network, 400.0);
+			for (int i = 0; i < 300; ++i) {
+				const StopId from = stop_pick(random);
+				const StopId to = stop_pick(random);
+				const auto fastest = router->findRoute(from, to);
+				const auto fewest = FewestTransfers(*router, from, to);
+				const string what = to_string(from) + " -> " + to_string(to);
+				Check((fastest == nullptr) == (fewest == nullptr), what + ": same reachability", __LINE__);
+				if (fastest == nullptr || fewest == nullptr) {
+					continue;
+				}
+				Check(CountBuses(*fewest) <= CountBuses(*fastest), what + ": no more buses than the fastest route", __LINE__);
+				Check(TotalTime(*fewest) + 0.05 * (fastest->size() + fewest->size()) >= TotalTime(*fastest), what + ": not faster than the fastest route", __LINE__);
+			}
+		}
+		{
+			// One slow bus from 0 to 2 against two fast ones through 1.
+			Network network;
+			for (int i = 0; i < 3; ++i) {
+				network.AddStop(55.70 + i * 0.1, 37.60);
+			}
+			network.AddBus(false, { 0, 2 });
+			network.AddBus(false, { 0, 1 });
+			network.AddBus(false, { 1, 2 });
+			network.SetDistance(0, 2, 9000);
+			network.SetDistance(0, 1, 1000);
+			network.SetDistance(1, 2, 1000);
+			const auto router = MakeRouter(network);
+
+			Check(Describe(router->findRoute(0, 2)) == "bus 1 0->1 stops 1 trip 100.000000 wait 360.000000; "
+				"bus 2 1->2 stops 1 trip 100.000000 wait 360.000000; ", "two buses are faster", __LINE__);
+			Check(Describe(FewestTransfers(*router, 0, 2)) == "bus 0 0->2 stops 1 trip 900.000000 wait 360.000000; ",
+				"one bus instead of two", __LINE__);
+		}
+		{
+			// Two single buses from 0 to 2; the faster one wins, though two buses through 1 are faster still.
+			Network network;
+			for (int i = 0; i < 3; ++i) {
+				network.AddStop(55.70 + i * 0.1, 37.60);
+			}
+			network.AddStop(55.75, 37.60);
+			network.AddBus(false, { 0, 2 });
+			network.AddBus(false, { 0, 3, 2 });
+			network.AddBus(false, { 0, 1 });
+			network.AddBus(false, { 1, 2 });
+			network.SetDistance(0, 2, 9000);
+			network.SetDistance(0, 3, 4000);
+			network.SetDistance(3, 2, 3000);
+			network.SetDistance(0, 1, 1000);
+			network.SetDistance(1, 2, 1000);
+			const auto router = MakeRouter(network);
+
+			Check(Describe(FewestTransfers(*router, 0, 2)) == "bus 1 0->2 stops 2 trip 700.000000 wait 360.000000; ",
+				"the earliest of the single buses", __LINE__);
+			Check(Describe(FewestTransfers(*router, 2, 0)) == "bus 1 2->0 stops 2 trip 700.000000 wait 360.000000; ",
+				"the earliest of the single buses back", __LINE__);
+		}
+		{
+			// A roundtrip bus 0 -> 1 -> 2 -> 0 only goes one way round, and a linear bus 3 -> 4 -> 5
+			// rides the road distances of the way back on its way back.
+			Network network;
+			for (int i = 0; i < 6; ++i) {
+				network.AddStop(55.70 + i * 0.1, 37.60);
+			}
+			network.AddBus(true, { 0, 1, 2, 0 });
+			network.AddBus(false, { 3, 4, 5 });
+			network.SetDistance(0, 1, 1000);
+			network.SetDistance(1, 2, 2000);
+			network.SetDistance(2, 0, 3000);
+			network.SetDistance(3, 4, 1000);
+			network.SetDistance(4, 5, 1000);
+			network.distances.Set(5, 4, 1500);
+			network.distances.Set(4, 3, 2500);
+			const auto router = MakeRouter(network);
+
+			Check(Describe(FewestTransfers(*router, 0, 2)) == "bus 0 0->2 stops 2 trip 300.000000 wait 360.000000; ",
+				"round the loop", __LINE__);
+			Check(Describe(FewestTransfers(*router, 1, 0)) == "bus 0 1->0 stops 2 trip 500.000000 wait 360.000000; ",
+				"round the loop to its end", __LINE__);
+			Check(Describe(FewestTransfers(*router, 2, 1)) == "bus 0 2->0 stops 1 trip 300.000000 wait 360.000000; "
+				"bus 0 0->1 stops 1 trip 100.000000 wait 360.000000; ", "past the end of the loop on the next trip", __LINE__);
+			Check(Describe(FewestTransfers(*router, 5, 3)) == "bus 1 5->3 stops 2 trip 400.000000 wait 360.000000; ",
+				"back along the line", __LINE__);
+			Check(Describe(FewestTransfers(*router, 3, 5)) == "bus 1 3->5 stops 2 trip 200.000000 wait 360.000000; ",
+				"along the line", __LINE__);
+			Check(Describe(FewestTransfers(*router, 0, 4)) == "no route", "no bus between the loop and the line", __LINE__);
+		}
+		{
+			// Stop 1 is 100 m north of stop 0 and stop 2 far away: walking beats the bus to 1 and
+			// the bus to 2 starts with a walk to 1.
+			Network network;
+			network.AddStop(55.70, 37.60);
+			network.AddStop(55.70 + 100.0 / 111195.0, 37.60);
+			network.AddStop(55.80, 37.60);
+			network.AddBus(false, { 0, 1 });
+			network.AddBus(false, { 1, 2 });
+			network.SetDistance(0, 1, 100);
+			network.SetDistance(1, 2, 11000);
+			const auto router = MakeRouter(network, 400.0);
+
+			const double walk = geo::GridIndex::Distance(network.stops[0].coordinates, network.stops[1].coordinates) / (5.0 / 3.6);
+			Check(walk > 71.9 && walk < 72.1, "100 m on foot", __LINE__);
+			Check(Describe(FewestTransfers(*router, 0, 1)) == "walk 0->1 stops 0 trip " + to_string(walk) + " wait 0.000000; ",
+				"no bus to walk to", __LINE__);
+			Check(Describe(FewestTransfers(*router, 0, 2)) == "walk 0->1 stops 0 trip " + to_string(walk) + " wait 0.000000; "
+				"bus 1 1->2 stops 1 trip 1100.000000 wait 360.000000; ", "walk to the only bus", __LINE__);
+		}
+	}
+
+	// The stop grid has cells as wide as the walking radius. The first stop is half a meter north
+	// of a cell boundary and the others a meter inside or outside the radius from it in eight
+	// directions, so they lie in this cell, the cells around it and the cells beyond those.
+	void TestWalkRadius() {
+		constexpr double RADIUS = 400.0;
+		const double lat_step = RADIUS / geo::METERS_PER_DEGREE;
+		const double boundary = std::ceil(55.75 / lat_step) * lat_step;
+
+		Network network;
+		const geo::Coordinates center{ boundary + 0.5 / geo::METERS_PER_DEGREE, 37.6 };
+		network.AddStop(center.lat, center.lng);
+		network.AddStop(boundary - 0.5 / geo::METERS_PER_DEGREE, center.lng);
+		const double lng_per_lat = 1.0 / std::cos(center.lat * 3.1415926535 / 180.);
+		for (int direction = 0; direction < 8; ++direction) {
+			const double angle = direction * 3.1415926535 / 4;
+			for (const double distance : { RADIUS - 1.0, RADIUS + 1.0 }) {
+				const double lat = distance * std::cos(angle) / geo::METERS_PER_DEGREE;
+				const double lng = distance * std::sin(angle) / geo::METERS_PER_DEGREE * lng_per_lat;
+				network.AddStop(center.lat + lat, center.lng + lng);
+			}
+		}
+
+		const auto router = MakeRouter(network, RADIUS);
+		const geo::GridIndex grid([&network] {
+			vector<geo::Coordinates> points;
+			for (const auto& stop : network.stops) {
+				points.push_back(stop.coordinates);
+			}
+			return points;
+		}(), RADIUS);
+
+		for (StopId to = 1; to < network.stops.size(); ++to) {
+			const double distance = geo::GridIndex::Distance(center, network.stops[to].coordinates);
+			const bool inside = to == 1 || to % 2 == 0;
+			const string what = "stop " + to_string(to) + " at " + to_string(distance) + " m";
+			Check(inside == (distance <= RADIUS), what + ": placed " + (inside ? "inside" : "outside"), __LINE__);
+
+			bool found = false;
+			grid.ForEachInRadius(center, RADIUS, [&found, to](size_t index, double) {
+				found = found || index == to;
+			});
+			Check(found == inside, what + ": found by the grid only inside the radius", __LINE__);
+
+			const string walk = "walk 0->" + to_string(to) + " stops 0 trip " + to_string(distance / (5.0 / 3.6)) + " wait 0.000000; ";
+			Check((Describe(router->findRoute(0, to)) == walk) == inside, what + ": walked straight to only inside the radius", __LINE__);
+			Check((Describe(FewestTransfers(*router, 0, to)) == walk) == inside, what + ": fewest transfers walk straight to only inside the radius", __LINE__);
+		}
+	}
+
+	// Positions are meters north and east of stop 0. Bus 0 runs 0 -> 1 -> 4 and bus 1 runs 3 -> 1;
+	// stop 2 is the one nearest to the start but has no bus.
+	void TestEndpoints() {
+		const geo::Coordinates origin{ 55.70, 37.60 };
+		auto at = [&origin](double north, double east) {
+			return geo::Coordinates{ origin.lat + north / geo::METERS_PER_DEGREE,
+				origin.lng + east / geo::METERS_PER_DEGREE / std::cos(origin.lat * 3.1415926535 / 180.) };
+		};
+		const geo::Coordinates start = at(-200, 0);
+		const geo::Coordinates finish = at(12300, 0);
+
+		Network network;
+		for (const auto& position : { at(0, 0), at(12000, 0), at(-250, 0), at(-200, 150), at(12400, 0) }) {
+			network.AddStop(position.lat, position.lng);
+		}
+		network.AddBus(false, { 0, 1, 4 });
+		network.AddBus(false, { 3, 1 });
+		network.SetDistance(0, 1, 11000);
+		network.SetDistance(1, 4, 400);
+		network.SetDistance(3, 1, 11500);
+		const auto router = MakeRouter(network);
+
+		// 200 m to stop 0 take 144 s against 108 s for the 150 m to stop 3, but the ride from 0 is
+		// 50 s shorter. Riding on from 1 to 4 takes 40 s and saves walking 200 m of the 300 m, 144 s.
+		Check(Describe(router->findRoute(start, finish), true) == "walk x->0 stops 0 trip 144 wait 0; "
+			"bus 0 0->4 stops 2 trip 1140 wait 360; walk 4->x stops 0 trip 72 wait 0; ", "from a position to a position", __LINE__);
+		Check(Describe(router->findRoute(start, StopId{ 1 }), true) == "walk x->0 stops 0 trip 144 wait 0; "
+			"bus 0 0->1 stops 1 trip 1100 wait 360; ", "from a position to a stop", __LINE__);
+		Check(Describe(router->findRoute(StopId{ 3 }, finish), true) == "bus 1 3->1 stops 1 trip 1150 wait 360; "
+			"walk 1->x stops 0 trip 216 wait 0; ", "from a stop to a position", __LINE__);
+		Check(Describe(router->findRoute(StopId{ 0 }, StopId{ 4 }), true) == "bus 0 0->4 stops 2 trip 1140 wait 360; ",
+			"from a stop to a stop", __LINE__);
+
+		// 300 m on foot take 216 s, less than any bus.
+		Check(Describe(router->findRoute(start, at(100, 0)), true) == "walk x->x stops 0 trip 216 wait 0; ",
+			"walking is faster", __LINE__);
+		Check(Describe(router->findRoute(StopId{ 2 }, finish)) == "no route", "no bus from the stop", __LINE__);
+
+		// Exactly the time of the walks measured on the sphere.
+		const auto route = router->findRoute(start, finish);
+		const double access = geo::GridIndex::Distance(start, network.stops[0].coordinates) / (5.0 / 3.6);
+		const double egress = geo::GridIndex::Distance(network.stops[4].coordinates, finish) / (5.0 / 3.6);
+		Check(route != nullptr && route->size() == 3 && route->front().trip_time == access && route->back().trip_time == egress,
+			"walk times of the access and egress", __LINE__);
+	}
+
+	// A route through via stops is its legs one after another.
+	void TestVia() {
+		mt19937 random(29);
+		const Network network = MakeNetwork(60, 25, random);
+		uniform_int_distribution<StopId> stop_pick(0, static_cast<StopId>(network.stops.size() - 1));
+
+		for (const RoutingEngine engine : { RoutingEngine::TABLE, RoutingEngine::OVERLAY }) {
+			for (const double walk_radius : { 0.0, 400.0 }) {
+				RoutingSettings settings(6, 40);
+				settings.engine = engine;
+				settings.walk_radius = walk_radius;
+				TransportRouter router(network.stops, network.buses, network.distances, settings);
+				router.BuildGraph();
+
+				for (const RouteMode mode : { RouteMode::TIME, RouteMode::FEWEST_TRANSFERS }) {
+					for (int i = 0; i < 100; ++i) {
+						vector<StopId> waypoints(2 + i % 4);
+						for (StopId& stop : waypoints) {
+							stop = stop_pick(random);
+						}
+						if (i % 10 == 0) {
+							waypoints[1] = waypoints[0];
+						}
+
+						string expected;
+						bool reachable = true;
+						for (size_t leg = 1; leg < waypoints.size() && reachable; ++leg) {
+							const auto route = router.findRoute({ waypoints[leg - 1], waypoints[leg] }, mode);
+							reachable = route != nullptr;
+							expected += reachable ? Describe(route) : Describe(nullptr);
+						}
+						if (!reachable) {
+							expected = Describe(nullptr);
+						}
+
+						const string what = "engine " + to_string(static_cast<int>(engine)) + ", walk " + to_string(walk_radius)
+							+ ", mode " + to_string(static_cast<int>(mode)) + ", route " + to_string(i);
+						Check(Describe(router.findRoute(waypoints, mode)) == expected, what + ": via route is its legs", __LINE__);
+					}
+				}
+			}
+		}
+	}
+
+}
+
+int main() {
+	TestOverlay();
+	TestVia();
+	TestFewestTransfers();
+	TestWalkRadius();
+	TestEndpoints();
+
+	if (failures > 0) {
+		cerr << failures << " checks failed"sv << endl;
+		return 1;
+	}
+	cout << "router_test OK"sv << endl;
+	return 0;
+}
@@ -45,6 +45,30 @@ namespace svg {
 		return out;
 	}
 
+	io::Sink& operator<<(io::Sink& out, Rgb color) {
+		return out << "rgb("sv << +color.red << ',' << +color.green << ',' << +color.blue << ')';
+	}
+
+	io::Sink& operator<<(io::Sink& out, Rgba color) {
+		return out << "rgba("sv << +color.red << ',' << +color.green << ',' << +color.blue << ',' << color.opacity << ')';
+	}
+
+	io::Sink& operator<<(io::Sink& out, const Color& color) {
+		if (std::holds_alternative<std::monostate>(color)) {
+			out << "none"sv;
+		}
+		else if (std::holds_alternative<std::string>(color)) {
+			out << std::get<std::string>(color);
+		}
+		else if (std::holds_alternative<Rgb>(color)) {
+			out << std::get<Rgb>(color);
+		}
+		else if (std::holds_alternative<Rgba>(color)) {
+			out << std::get<Rgba>(color);
+		}
+		return out;
+	}
+
 	inline uint8_t Lerp(uint8_t from, uint8_t to, double t) {
 		return static_cast<uint8_t>(std::round((to - from) * t + from));
 	}
@@ -77,13 +101,35 @@ namespace svg {
 		return out;
 	}
 
+	io::Sink& operator<<(io::Sink& out, StrokeLineCap cap) {
+		switch (cap) {
+		case StrokeLineCap::BUTT: out << "butt"sv; break;
+		case StrokeLineCap::ROUND: out << "round"sv; break;
+		case StrokeLineCap::SQUARE: out << "square"sv; break;
+		default: break;
+		}
+		return out;
+	}
+
+	io::Sink& operator<<(io::Sink& out, StrokeLineJoin join) {
+		switch (join) {
+		case StrokeLineJoin::ARCS: out << "arcs"sv; break;
+		case StrokeLineJoin::BEVEL: out << "bevel"sv; break;
+		case StrokeLineJoin::MITER: out << "miter"sv; break;
+		case StrokeLineJoin::MITER_CLIP: out << "miter-clip"sv; break;
+		case StrokeLineJoin::ROUND: out << "round"sv; break;
+		default: break;
+		}
+		return out;
+	}
+
 	RenderContext RenderContext::Indented() const {
 		return { out, indent_step, indent + indent_step };
 	}
 
 	void RenderContext::RenderIndent() const {
 		for (int i = 0; i < indent; ++i) {
-			out.put(' ');
+			out << ' ';
 		}
 	}
 
@@ -94,7 +140,7 @@ namespace svg {
 
 		RenderObject(context);
 
-		context.out << std::endl;
+		context.out << '\n';
 	}
 
 	Circle& Circle::SetCenter(Point center) {
@@ -165,11 +211,11 @@ namespace svg {
 
 	void Text::RenderObject(const RenderContext& context) const {
 		auto& out = context.out;
-		out << "<text";
+		out << "<text"sv;
 		RenderAttrs(context.out);
 		out << " x=\""sv << position_.x << "\" y=\""sv << position_.y << "\" "sv
 			<< "dx=\""sv << offset_.x << "\" dy=\""sv << offset_.y << "\" "sv
-			<< "font-size=\""sv << size_ << "\"";
+			<< "font-size=\""sv << size_ << '"';
 
 		if (font_family_.size() != 0) {
 			out << " font-family=\""sv << font_family_ << "\""sv;
@@ -180,18 +226,22 @@ namespace svg {
 
 		out << ">"sv;
 
-		for (char c : value_) {
-			switch (c) {
-			case '"': out << "&quot;"sv; break;
-			case '\'': out << "&apos;"sv; break;
-			case '<': out << "&lt;"sv; break;
-			case '>': out << "&gt;"sv; break;
-			case '&': out << "&amp;"sv; break;
-			default:
-				out << c;
+		const std::string_view value = value_;
+		size_t run = 0;
+		for (size_t i = 0; i < value.size(); ++i) {
+			std::string_view escaped;
+			switch (value[i]) {
+			case '"': escaped = "&quot;"sv; break;
+			case '\'': escaped = "&apos;"sv; break;
+			case '<': escaped = "&lt;"sv; break;
+			case '>': escaped = "&gt;"sv; break;
+			case '&': escaped = "&amp;"sv; break;
+			default: continue;
 			}
+			out << value.substr(run, i - run) << escaped;
+			run = i + 1;
 		}
-		out << "</text>"sv;
+		out << value.substr(run) << "</text>"sv;
 	}
 
 	void Document::AddPointer(std::shared_ptr<Object>&& obj) {
@@ -199,10 +249,15 @@ namespace svg {
 	}
 
 	void Document::Render(std::ostream& out) const {
+		io::Sink sink(out);
+		Render(sink);
+	}
+
+	void Document::Render(io::Sink& out) const {
 		out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
 		out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
 		for (size_t index = 0; index < objects_.size(); ++index) {
-			out << "  ";
+			out << "  "sv;
 			objects_.at(index)->Render(out);
 		}
 		out << "</svg>"sv;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "output_sink.h"
+
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -64,6 +66,10 @@ namespace svg {
 
 	inline std::ostream& operator<<(std::ostream& out, Color color);
 
+	io::Sink& operator<<(io::Sink& out, Rgb color);
+	io::Sink& operator<<(io::Sink& out, Rgba color);
+	io::Sink& operator<<(io::Sink& out, const Color& color);
+
 
 	inline uint8_t Lerp(uint8_t from, uint8_t to, double t);
 
@@ -73,6 +79,9 @@ namespace svg {
 
 	inline std::ostream& operator<< (std::ostream& out, const StrokeLineJoin join);
 
+	io::Sink& operator<<(io::Sink& out, StrokeLineCap cap);
+	io::Sink& operator<<(io::Sink& out, StrokeLineJoin join);
+
 	template <typename Owner>
 	class PathProps {
 	public:
@@ -103,7 +112,7 @@ namespace svg {
 	protected:
 		~PathProps() = default;
 
-		void RenderAttrs(std::ostream& out) const {
+		void RenderAttrs(io::Sink& out) const {
 			using namespace std::literals;
 
 			if (fill_color_) {
@@ -144,11 +153,11 @@ namespace svg {
 	};
 
 	struct RenderContext {
-		RenderContext(std::ostream& out)
+		RenderContext(io::Sink& out)
 			: out(out) {
 		}
 
-		RenderContext(std::ostream& out, int indent_step, int indent = 0)
+		RenderContext(io::Sink& out, int indent_step, int indent = 0)
 			: out(out)
 			, indent_step(indent_step)
 			, indent(indent) {
@@ -158,7 +167,7 @@ namespace svg {
 
 		void RenderIndent() const;
 
-		std::ostream& out;
+		io::Sink& out;
 		int indent_step = 0;
 		int indent = 0;
 	};
@@ -244,6 +253,7 @@ namespace svg {
 		void AddPointer(std::shared_ptr<Object>&& obj);
 
 		void Render(std::ostream& out) const;
+		void Render(io::Sink& out) const;
 
 	private:
 		std::vector<std::shared_ptr<Object>> objects_;
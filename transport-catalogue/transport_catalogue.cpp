@@ -1,6 +1,8 @@
 ﻿#include "transport_catalogue.h"
 
 #include "transport_catalogue.pb.h"
+#include "json_writer.h"
+#include "parallel.h"
 
 #include <algorithm>
 #include <stdexcept>
@@ -8,126 +10,305 @@
 
 namespace transport::catalogue {
 
+	namespace {
+
+		// Orders items by name; of items with the same name only the last one is kept.
+		template <typename Item>
+		void SortByName(std::vector<Item>& items) {
+			std::stable_sort(items.begin(), items.end(), [](const Item& lhs, const Item& rhs) {
+				return lhs.name < rhs.name;
+			});
+
+			auto out = items.begin();
+			for (auto it = items.begin(); it != items.end(); ++it) {
+				if (std::next(it) != items.end() && std::next(it)->name == it->name) {
+					continue;
+				}
+				if (out != it) {
+					*out = std::move(*it);
+				}
+				++out;
+			}
+			items.erase(out, items.end());
+		}
+
+	}
+
 	TransportCatalogue::TransportCatalogue(
-		std::vector<std::shared_ptr<Stop>>& stops,
-		std::vector<std::shared_ptr<Bus>>& buses,
+		NamePool names,
+		std::vector<Stop> stops,
+		std::vector<Bus> buses,
 		RenderSettings render_settings,
 		RoutingSettings router_settings
-	) {
-
-		for (auto& stop : stops) {
-			stops_[stop->name] = stop;
+	)
+		: names_(std::move(names))
+		, stops_(std::move(stops))
+		, buses_(std::move(buses))
+	{
+		SortByName(stops_);
+		SortByName(buses_);
+		names_.IndexAll();
+		name_index_ = NameIndex(names_, stops_, buses_);
+
+		// Buses come with the name ids of their stops.
+		std::vector<StopId> stop_by_name(names_.Size(), NO_ID);
+		for (StopId id = 0; id < stops_.size(); ++id) {
+			stop_by_name[names_.GetId(stops_[id].name)] = id;
 		}
+		FillDistances(stop_by_name);
+
+		// Every bus on its own: the sorted stops of a bus without repeats are kept
+		// for the stop-to-bus incidence.
+		std::vector<std::vector<StopId>> bus_stops(buses_.size());
+		parallel::ForEachIndex(buses_.size(), [this, &stop_by_name, &bus_stops](size_t id) {
+			Bus& bus = buses_[id];
+			for (StopId& stop : bus.stops) {
+				stop = stop_by_name.at(stop);
+				if (stop == NO_ID) {
+					throw std::out_of_range("unknown stop on bus " + std::string(bus.name));
+				}
+			}
 
-		for (auto& bus : buses) {
-			buses_[bus->name] = bus;
+			std::vector<StopId>& unique = bus_stops[id];
+			unique = bus.stops;
+			std::sort(unique.begin(), unique.end());
+			unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+			bus.unique_stop_count = unique.size();
 
-			std::set<std::string_view> stops_uniq;
-			for (auto& stop : bus->stops) {
-				stops_uniq.insert(stop);
-				stops_[stop]->buses.insert(bus->name);
-			}
-			bus->unique_stop_count = stops_uniq.size();
+			ComputeRouteStats(bus);
+		});
+		FillStopBuses(bus_stops);
 
-			double len_by_coordinates = 0;
-			for (size_t i = 0; i + 1 < bus->stops.size(); i++) {
-				len_by_coordinates += geo::ComputeDistance(
-					stops_[bus->stops[i]]->coordinates,
-					stops_[bus->stops[i + 1]]->coordinates
-				);
+		render_ = std::make_unique<MapRenderer>(stops_, buses_, render_settings);
+		map_ = render_->render_map();
 
-				bus->route_length += RealLenBeetwenStops(stops_[bus->stops[i]], stops_[bus->stops[i + 1]]);
-			}
 
+		router_ = std::make_unique<TransportRouter>(stops_, buses_, distances_, router_settings);
+		router_->BuildGraph();
+	}
 
-			if (bus->is_roundtrip) {
-				bus->stop_count = bus->stops.size();
+	void TransportCatalogue::ComputeRouteStats(Bus& bus) const {
+		double len_by_coordinates = 0;
+		for (size_t i = 0; i + 1 < bus.stops.size(); i++) {
+			const Stop& from = stops_[bus.stops[i]];
+			const Stop& to = stops_[bus.stops[i + 1]];
+			len_by_coordinates += geo::ComputeDistance(from.coordinates, to.coordinates);
+			bus.route_length += distances_.Get(bus.stops[i], bus.stops[i + 1]);
+		}
+
+		if (bus.is_roundtrip) {
+			bus.stop_count = bus.stops.size();
+		}
+		else {
+			bus.stop_count = bus.stops.size() * 2 - 1;
+			len_by_coordinates *= 2;
+
+			for (int i = bus.stops.size() - 1; i - 1 > -1; i--) {
+				bus.route_length += distances_.Get(bus.stops[i], bus.stops[i - 1]);
 			}
-			else {
-				bus->stop_count = bus->stops.size() * 2 - 1;
-				len_by_coordinates *= 2;
+		}
 
-				for (int i = bus->stops.size() - 1; i - 1 > -1; i--) {
-					bus->route_length += RealLenBeetwenStops(stops_[bus->stops[i]], stops_[bus->stops[i - 1]]);
+		bus.curvature = (bus.route_length / len_by_coordinates) * 1.0;
+	}
+
+	// Buses are split into blocks that count their stops first, so each block knows where
+	// its buses go in every Stop::buses and the lists come out in bus id order however
+	// many workers fill them. Every block keeps a counter per stop, so the block count is
+	// capped at the average number of buses per stop: the counters then never take more
+	// memory than the lists they fill.
+	void TransportCatalogue::FillStopBuses(const std::vector<std::vector<StopId>>& bus_stops) {
+		size_t incidences = 0;
+		for (const auto& stops : bus_stops) {
+			incidences += stops.size();
+		}
+		const size_t per_stop = incidences / std::max<size_t>(1, stops_.size());
+		const size_t blocks = parallel::WorkerCount(std::min(bus_stops.size(), std::max<size_t>(1, per_stop)));
+		const size_t block_size = (bus_stops.size() + blocks - 1) / blocks;
+		auto for_each_stop = [&bus_stops, block_size](size_t block, auto func) {
+			const size_t end = std::min(bus_stops.size(), (block + 1) * block_size);
+			for (size_t bus = block * block_size; bus < end; ++bus) {
+				for (const StopId stop : bus_stops[bus]) {
+					func(static_cast<BusId>(bus), stop);
 				}
 			}
-
-			bus->curvature = (bus->route_length / len_by_coordinates) * 1.0;
+		};
+
+		std::vector<std::vector<uint32_t>> positions(blocks, std::vector<uint32_t>(stops_.size(), 0));
+		parallel::ForEachIndex(blocks, [&](size_t block) {
+			for_each_stop(block, [&positions, block](BusId, StopId stop) {
+				++positions[block][stop];
+			});
+		});
+
+		for (StopId stop = 0; stop < stops_.size(); ++stop) {
+			uint32_t total = 0;
+			for (auto& block_positions : positions) {
+				const uint32_t count = block_positions[stop];
+				block_positions[stop] = total;
+				total += count;
+			}
+			stops_[stop].buses.assign(total, NO_ID);
 		}
 
-		render_ = std::make_unique<MapRenderer>(stops_, buses_, render_settings);
-		map_ = render_->render_map();
+		parallel::ForEachIndex(blocks, [&](size_t block) {
+			for_each_stop(block, [this, &positions, block](BusId bus, StopId stop) {
+				stops_[stop].buses[positions[block][stop]++] = bus;
+			});
+		});
+	}
 
+	std::optional<StopView> TransportCatalogue::GetStopInfo(std::string_view stop_name) const {
+		const Stop* stop = StopByName(stop_name);
+		if (stop == nullptr) return std::nullopt;
+		return StopView(*stop, buses_);
+	}
 
-		router_ = std::make_unique<TransportRouter>(stops_,buses_,router_settings);
-		router_->BuildGraph();
+	std::optional<BusView> TransportCatalogue::GetBusInfo(std::string_view bus_name) const {
+		const Bus* bus = BusByName(bus_name);
+		if (bus == nullptr) return std::nullopt;
+		return BusView{ bus->name, bus->stop_count, bus->unique_stop_count, bus->route_length, bus->curvature };
+	}
+
+	const Stop* TransportCatalogue::StopByName(std::string_view name) const {
+		const auto id = FindStop(name);
+		if (!id) return nullptr;
+		return &stops_[*id];
+	}
+
+	const Bus* TransportCatalogue::BusByName(std::string_view name) const {
+		const NameIndex::Entry* entry = name_index_.Find(name, names_);
+		if (entry == nullptr || entry->bus == NO_ID) return nullptr;
+		return &buses_[entry->bus];
 	}
 
-	std::optional<Stop> TransportCatalogue::GetStopInfo(std::string_view stop_name) {
-		auto result = StopByName(stop_name);
-		if (result == nullptr) return {};
-		return *result;
+	const Stop& TransportCatalogue::GetStop(StopId id) const {
+		return stops_.at(id);
 	}
 
-	std::optional<Bus> TransportCatalogue::GetBusInfo(std::string_view bus_name) {
-		auto result = BusByName(bus_name);
-		if (result == nullptr) return {};
-		return *result;
+	const Bus& TransportCatalogue::GetBus(BusId id) const {
+		return buses_.at(id);
 	}
 
-	std::shared_ptr<Stop> TransportCatalogue::StopByName(std::string_view name) {
-		auto it = stops_.find(name);
-		if (it == stops_.end()) return nullptr;
-		return it->second;
+	std::optional<StopId> TransportCatalogue::FindStop(std::string_view name) const {
+		const NameIndex::Entry* entry = name_index_.Find(name, names_);
+		if (entry == nullptr || entry->stop == NO_ID) return std::nullopt;
+		return entry->stop;
 	}
-	std::shared_ptr<Bus> TransportCatalogue::BusByName(std::string_view name) {
-		auto it = buses_.find(name);
-		if (it == buses_.end()) return nullptr;
-		return it->second;
+
+	// Takes the distances out of the stops. A distance given only one way holds both ways,
+	// which is settled here once instead of on every lookup.
+	void TransportCatalogue::FillDistances(const std::vector<StopId>& stop_by_name) {
+		size_t count = 0;
+		for (const Stop& stop : stops_) {
+			count += stop.road_distanse.size();
+		}
+		distances_.Reserve(count * 2);
+
+		for (StopId id = 0; id < stops_.size(); ++id) {
+			for (const auto& [name_id, distance] : stops_[id].road_distanse) {
+				if (const StopId to = stop_by_name.at(name_id); to != NO_ID) {
+					distances_.Set(id, to, distance);
+				}
+			}
+		}
+		for (StopId id = 0; id < stops_.size(); ++id) {
+			for (const auto& [name_id, distance] : stops_[id].road_distanse) {
+				if (const StopId to = stop_by_name.at(name_id); to != NO_ID) {
+					distances_.SetIfMissing(to, id, distances_.Get(id, to));
+				}
+			}
+			stops_[id].road_distanse = {};
+		}
 	}
 
 	const std::string& TransportCatalogue::GetMap() {
 		return map_;
 	}
 
+	const std::string& TransportCatalogue::GetMapJson() {
+		if (map_json_.empty()) {
+			map_json_.reserve(map_.size() + map_.size() / 8);
+			json::Writer(map_json_).Value(map_);
+		}
+		return map_json_;
+	}
+
 	std::shared_ptr<std::vector<RouteItem>> TransportCatalogue::findRouteInBase(std::string_view from, std::string_view to) {
-		return router_->findRoute(from.data(), to.data());
+		const auto from_id = FindStop(from);
+		const auto to_id = FindStop(to);
+		if (!from_id || !to_id) return nullptr;
+		return router_->findRoute(*from_id, *to_id);
+	}
+
+	std::shared_ptr<std::vector<RouteItem>> TransportCatalogue::findRouteInBase(const std::vector<std::string_view>& waypoints, RouteMode mode) {
+		std::vector<StopId> stops;
+		stops.reserve(waypoints.size());
+		for (const std::string_view name : waypoints) {
+			const auto id = FindStop(name);
+			if (!id) return nullptr;
+			stops.push_back(*id);
+		}
+		return router_->findRoute(stops, mode);
+	}
+
+	std::shared_ptr<std::vector<RouteItem>> TransportCatalogue::findRouteInBase(const RoutePoint& from, const RoutePoint& to) {
+		auto resolve = [this](const RoutePoint& point) -> std::optional<RouteEndpoint> {
+			if (const auto* coordinates = std::get_if<geo::Coordinates>(&point)) {
+				return *coordinates;
+			}
+			if (const auto id = FindStop(std::get<std::string_view>(point))) {
+				return *id;
+			}
+			return std::nullopt;
+		};
+
+		const auto from_endpoint = resolve(from);
+		const auto to_endpoint = resolve(to);
+		if (!from_endpoint || !to_endpoint) return nullptr;
+		return router_->findRoute(*from_endpoint, *to_endpoint);
 	}
 
 	std::string TransportCatalogue::Serialize() const {
 		TCProto::TransportCatalogue db_proto;
 
-		for (const auto& [name, stop] : stops_) {
+		for (NamePool::Id id = 0; id < names_.Size(); ++id) {
+			db_proto.add_names(std::string(names_.GetName(id)));
+		}
+
+		for (const Stop& stop : stops_) {
 			TCProto::Stop& proto_stop = *db_proto.add_map_stops();
-			proto_stop.set_name(stop->name);
-			proto_stop.set_lat(stop->coordinates.lat);
-			proto_stop.set_lng(stop->coordinates.lng);
+			proto_stop.set_name_id(name_index_.Find(stop.name, names_)->name);
+			proto_stop.set_lat(stop.coordinates.lat);
+			proto_stop.set_lng(stop.coordinates.lng);
 
-			for (const std::string_view& bus_name : stop->buses) {
-				proto_stop.add_bus_name(std::string(bus_name));
+			for (const BusId bus : stop.buses) {
+				proto_stop.add_bus_ids(bus);
 			}
 
-			for (const auto& [name, len] : stop->road_distanse) {
-				auto& road =  *proto_stop.add_road_distanse();
-				road.set_name(name);
-				road.set_len(len);
-			}
 		}
 
+		TCProto::RoadDistances& proto_distances = *db_proto.mutable_road_distances();
+		distances_.ForEach([&proto_distances](StopId from, StopId to, int distance) {
+			proto_distances.add_from(from);
+			proto_distances.add_to(to);
+			proto_distances.add_distance(distance);
+		});
+
 
-		for (const auto& [name, bus] : buses_) {
+		for (const Bus& bus : buses_) {
 			TCProto::Bus& proto_bus = *db_proto.add_map_buses();
-			proto_bus.set_name(bus->name);
-			proto_bus.set_is_roundtrip(bus->is_roundtrip);
-			proto_bus.set_stop_count(bus->stop_count);
-			proto_bus.set_unique_stop_count(bus->unique_stop_count);
-			proto_bus.set_route_length(bus->route_length);
-			proto_bus.set_curvature(bus->curvature);
-
-			for (const std::string& stop : bus->stops) {
-				proto_bus.add_stops_name(stop);
+			proto_bus.set_name_id(name_index_.Find(bus.name, names_)->name);
+			proto_bus.set_is_roundtrip(bus.is_roundtrip);
+			proto_bus.set_stop_count(bus.stop_count);
+			proto_bus.set_unique_stop_count(bus.unique_stop_count);
+			proto_bus.set_route_length(bus.route_length);
+			proto_bus.set_curvature(bus.curvature);
+
+			for (const StopId stop : bus.stops) {
+				proto_bus.add_stop_ids(stop);
 			}
 		}
+		name_index_.Serialize(*db_proto.mutable_name_index());
 
 		db_proto.set_catalogue_map(map_);
 
@@ -142,49 +323,76 @@ namespace transport::catalogue {
 
 	void TransportCatalogue::Deserialize(const std::string& data) {
 		TCProto::TransportCatalogue proto;
-		assert(proto.ParseFromString(data));
+		if (!proto.ParseFromString(data)) {
+			throw std::runtime_error("invalid serialized catalogue");
+		}
 
+		// Every id is checked against what it refers to, so a corrupt base fails here
+		// instead of reading past the stops or buses later.
+		const size_t name_count = proto.names_size();
+		const size_t stop_count = proto.map_stops_size();
+		const size_t bus_count = proto.map_buses_size();
+		auto check_id = [](uint32_t id, size_t count) {
+			if (id >= count) {
+				throw std::runtime_error("invalid serialized catalogue");
+			}
+		};
 
-		for (const TCProto::Stop& proto_stop : proto.map_stops()) {
-			Stop stop;
-			stop.name = proto_stop.name();
-			stop.coordinates = { proto_stop.lat(), proto_stop.lng() };
+		names_ = NamePool();
+		for (const auto& name : proto.names()) {
+			names_.Append(name);
+		}
 
-			for (const auto& name : proto_stop.bus_name()) {
-				stop.buses.insert(name);
+		stops_.clear();
+		stops_.reserve(stop_count);
+		for (const TCProto::Stop& proto_stop : proto.map_stops()) {
+			check_id(proto_stop.name_id(), name_count);
+			for (const uint32_t bus : proto_stop.bus_ids()) {
+				check_id(bus, bus_count);
 			}
 
-			for (const auto& road : proto_stop.road_distanse()) {
-				stop.road_distanse[road.name()] = road.len();
-			}
+			Stop& stop = stops_.emplace_back();
+			stop.name = names_.GetName(proto_stop.name_id());
+			stop.coordinates = { proto_stop.lat(), proto_stop.lng() };
+			stop.buses.assign(proto_stop.bus_ids().begin(), proto_stop.bus_ids().end());
+		}
 
-			auto ptr = std::make_shared<Stop>(stop);
-			stops_[ptr->name] = ptr;
+		const TCProto::RoadDistances& proto_distances = proto.road_distances();
+		if (proto_distances.from_size() != proto_distances.distance_size() || proto_distances.to_size() != proto_distances.distance_size()) {
+			throw std::runtime_error("invalid serialized catalogue");
+		}
+		distances_ = RoadDistances();
+		distances_.Reserve(proto_distances.distance_size());
+		for (int i = 0; i < proto_distances.distance_size(); ++i) {
+			distances_.Set(proto_distances.from(i), proto_distances.to(i), proto_distances.distance(i));
 		}
 
+		buses_.clear();
+		buses_.reserve(bus_count);
 		for (const TCProto::Bus& proto_bus : proto.map_buses()) {
-			Bus bus;
+			check_id(proto_bus.name_id(), name_count);
+			for (const uint32_t stop : proto_bus.stop_ids()) {
+				check_id(stop, stop_count);
+			}
 
-			bus.name = proto_bus.name();
+			Bus& bus = buses_.emplace_back();
+			bus.name = names_.GetName(proto_bus.name_id());
 			bus.is_roundtrip = proto_bus.is_roundtrip();
 			bus.stop_count = proto_bus.stop_count();
 			bus.unique_stop_count = proto_bus.unique_stop_count();
 			bus.route_length = proto_bus.route_length();
 			bus.curvature = proto_bus.curvature();
 
-			for (const auto& name : proto_bus.stops_name()) {
-				bus.stops.push_back(name);
-			}
-
-			auto ptr = std::make_shared<Bus>(bus);
-			buses_[ptr->name] = ptr;
+			bus.stops.assign(proto_bus.stop_ids().begin(), proto_bus.stop_ids().end());
 		}
+		name_index_ = NameIndex::Deserialize(proto.name_index(), names_, stops_.size(), buses_.size());
 
 
 		render_ = std::make_unique<MapRenderer>(stops_, buses_, MapRenderer::DeserializeSettings(proto.renderer_settings()));
 		map_ = proto.catalogue_map();
+		map_json_.clear();
 
-		router_ = std::make_unique<TransportRouter>(stops_, buses_, TransportRouter::DeserializeSettings(proto.routing_settings()));
+		router_ = std::make_unique<TransportRouter>(stops_, buses_, distances_, TransportRouter::DeserializeSettings(proto.routing_settings()));
 		router_->DeserializeData(proto.router());
 
 	}
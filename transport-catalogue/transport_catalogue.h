@@ -2,6 +2,7 @@
 #include "geo.h"
 #include "json.h"
 #include "domain.h"
+#include "name_index.h"
 #include "map_renderer.h"
 #include "transport_router.h"
 
@@ -28,14 +29,52 @@ namespace transport::catalogue {
 	using namespace transport::router;
 
 
+	// The answer to a Stop request, read in place from the catalogue.
+	class StopView {
+	public:
+		StopView(const Stop& stop, const std::vector<Bus>& buses)
+			: stop_(stop)
+			, buses_(buses) {}
+
+		std::string_view GetName() const {
+			return stop_.name;
+		}
+
+		size_t GetBusCount() const {
+			return stop_.buses.size();
+		}
+
+		// In the order of the names.
+		std::string_view GetBusName(size_t index) const {
+			return buses_[stop_.buses[index]].name;
+		}
+
+	private:
+		const Stop& stop_;
+		const std::vector<Bus>& buses_;
+	};
+
+	// The answer to a Bus request: only the statistics, without the stops.
+	struct BusView {
+		std::string_view name;
+		int stop_count = 0;
+		int unique_stop_count = 0;
+		double route_length = 0.0;
+		double curvature = 0.0;
+	};
+
 	class TransportCatalogue {
 	public:
 
 		TransportCatalogue() = default;
 
+		// Stop and bus names have to be interned in names, which the catalogue takes over.
+		// Stops and buses are numbered in the order of their names; of several with the
+		// same name the last one is kept.
 		TransportCatalogue(
-			std::vector<std::shared_ptr<Stop>>& stops,
-			std::vector<std::shared_ptr<Bus>>& buses,
+			NamePool names,
+			std::vector<Stop> stops,
+			std::vector<Bus> buses,
 			RenderSettings render_settings,
 			RoutingSettings router_settings
 		);
@@ -43,29 +82,48 @@ namespace transport::catalogue {
 
 		~TransportCatalogue() {}
 
-		std::optional<Stop> GetStopInfo(std::string_view stop_name);
+		// Views stay valid while the catalogue is neither destroyed nor deserialized into.
+		std::optional<StopView> GetStopInfo(std::string_view stop_name) const;
 
-		std::optional<Bus> GetBusInfo(std::string_view bus_name);
+		std::optional<BusView> GetBusInfo(std::string_view bus_name) const;
 		
-		std::shared_ptr<Stop> StopByName(std::string_view name); 
-		std::shared_ptr<Bus> BusByName(std::string_view name);
+		// nullptr when there is no such stop or bus.
+		const Stop* StopByName(std::string_view name) const;
+		const Bus* BusByName(std::string_view name) const;
+
+		const Stop& GetStop(StopId id) const;
+		const Bus& GetBus(BusId id) const;
 
 		const std::string& GetMap();
+		// The map as a JSON string literal, escaped once on first use.
+		const std::string& GetMapJson();
 
 		std::shared_ptr<std::vector<RouteItem>> findRouteInBase(std::string_view from, std::string_view to);
+		std::shared_ptr<std::vector<RouteItem>> findRouteInBase(const std::vector<std::string_view>& waypoints, RouteMode mode = RouteMode::TIME);
+		std::shared_ptr<std::vector<RouteItem>> findRouteInBase(const RoutePoint& from, const RoutePoint& to);
 
 
 		std::string Serialize() const;
 		void Deserialize(const std::string& data);
 
 	private:
-		std::map<std::string_view, std::shared_ptr<Stop>> stops_;
-		std::map<std::string_view, std::shared_ptr<Bus>> buses_;
+		NamePool names_;
+		std::vector<Stop> stops_;
+		std::vector<Bus> buses_;
+		// Built by the constructor and stored in the base, so Deserialize has nothing to hash.
+		NameIndex name_index_;
+		RoadDistances distances_;
 
 		std::unique_ptr<MapRenderer> render_;
 		std::unique_ptr<TransportRouter>router_;
 
 		std::string map_;
+		std::string map_json_;
+
+		void FillDistances(const std::vector<StopId>& stop_by_name);
+		void ComputeRouteStats(Bus& bus) const;
+		void FillStopBuses(const std::vector<std::vector<StopId>>& bus_stops);
+		std::optional<StopId> FindStop(std::string_view name) const;
 	};
 
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "transport_router.h"
+#include "parallel.h"
 
 #include "transport_router.pb.h"
 #include <iostream>
+#include <limits>
+#include <queue>
+#include <stdexcept>
 namespace transport::router {
 
     using namespace transport::domains;
@@ -9,150 +13,477 @@ namespace transport::router {
     void TransportRouter::SerializeSettings(TCProto::RoutingSettings& proto) {
         proto.set_bus_wait_time(settings_.bus_wait_time);
         proto.set_bus_velocity(settings_.bus_velocity);
+        proto.set_engine(static_cast<TCProto::RoutingEngine>(settings_.engine));
+        proto.set_walk_radius(settings_.walk_radius);
+        proto.set_walk_velocity(settings_.walk_velocity);
     }
 
     RoutingSettings TransportRouter::DeserializeSettings(const TCProto::RoutingSettings& proto) {
-        return { proto.bus_wait_time(), proto.bus_velocity() };
+        RoutingSettings settings;
+        settings.bus_wait_time = proto.bus_wait_time();
+        settings.bus_velocity = proto.bus_velocity();
+        settings.engine = static_cast<RoutingEngine>(proto.engine());
+        settings.walk_radius = proto.walk_radius();
+        settings.walk_velocity = proto.walk_velocity();
+        return settings;
     }
 
     TransportRouter::TransportRouter(
-        std::map<std::string_view, std::shared_ptr<Stop>>& stops,
-        std::map<std::string_view, std::shared_ptr<Bus>>& buses,
+        const std::vector<Stop>& stops,
+        const std::vector<Bus>& buses,
+        const RoadDistances& distances,
         RoutingSettings settings
     )
-        : settings_(settings)
-        , stops_(stops)
-        , buses_(buses) {
+        : stops_(stops)
+        , buses_(buses)
+        , distances_(distances)
+        , settings_(settings) {
     }
 
     void TransportRouter::BuildGraph() {
-        graph_ = graph::DirectedWeightedGraph<double>(stops_.size());
- 
-        FillVertexes();
+        FillLines();
         FillEdges();
+        IndexWalkEdges();
 
-        search_in_graph_ = std::make_unique<graph::Router<double>>(graph_);
+        if (UseOverlay()) {
+            overlay_ = std::make_unique<graph::OverlayRouter<RouteWeight>>(graph_, stop_grid_.GetPoints());
+        }
+        else {
+            search_in_graph_ = std::make_unique<graph::Router<RouteWeight>>(graph_);
+        }
+    }
+
+    bool TransportRouter::UseOverlay() const {
+        switch (settings_.engine) {
+        case RoutingEngine::TABLE:
+            return false;
+        case RoutingEngine::OVERLAY:
+            return true;
+        default:
+            return stops_.size() >= OVERLAY_MIN_STOP_COUNT;
+        }
     }
 
-    void TransportRouter::FillVertexes() {
-        size_t i = 0;
-        for (auto [_, stop] : stops_) {
-            graph_vertexes_[stop] = i++;
+    void TransportRouter::FillLines() {
+        std::vector<geo::Coordinates> positions(stops_.size());
+        for (StopId id = 0; id < stops_.size(); ++id) {
+            positions[id] = stops_[id].coordinates;
         }
+        stop_grid_ = geo::GridIndex(std::move(positions), settings_.walk_radius > 0 ? settings_.walk_radius : STOP_GRID_CELL_SIZE);
+
+        lines_.assign(buses_.size(), BusLine{});
+        parallel::ForEachIndex(lines_.size(), [this](size_t i) {
+            BusLine& line = lines_[i];
+            line.bus = static_cast<BusId>(i);
+            const auto& stops = LineBus(line).stops;
+
+            line.distance_forward.assign(stops.size(), 0.0);
+            line.distance_reverse.assign(stops.size(), 0.0);
+            for (size_t index = 1; index < stops.size(); index++) {
+                const StopId from = stops[index - 1];
+                const StopId to = stops[index];
+                line.distance_forward[index] = line.distance_forward[index - 1] + distances_.Get(from, to);
+                line.distance_reverse[index] = line.distance_reverse[index - 1] + distances_.Get(to, from);
+            }
+        });
     }
+
+    size_t TransportRouter::CountBusEdges(const Bus& route) {
+        const size_t stop_count = route.stops.size();
+        const size_t pairs = stop_count < 2 ? 0 : stop_count * (stop_count - 1) / 2;
+        return route.is_roundtrip ? pairs : pairs * 2;
+    }
+
     void TransportRouter::FillEdges() {
-        for (auto [_, route] : buses_) {
-
-            std::vector<double> distance_forward;
-            distance_forward.resize(route->stops.size());
-            std::vector<double> distance_reverse;
-            distance_reverse.resize(route->stops.size());
-
-            double forward_sum = 0.0;
-            double reverse_sum = 0.0;
-
-            for (size_t index = 1; index < route->stops.size(); index++) {
-                forward_sum += RealLenBeetwenStops(stops_.at(route->stops[index - 1]), stops_.at(route->stops[index]));
-                distance_forward[index] = forward_sum;
-                reverse_sum += RealLenBeetwenStops(stops_.at(route->stops[index]), stops_.at(route->stops[index - 1]));
-                distance_reverse[index] = reverse_sum;
-            }
-
-            for (int s = 0; s + 1 < route->stops.size(); s++) {
-                for (int s1 = s + 1; s1 < route->stops.size(); s1++) {
-                    RouteItem item;
-                    item.start_stop_idx = stops_.at(route->stops[s]);
-                    item.finish_stop_idx = stops_.at(route->stops[s1]);
-                    item.bus = route;
-                    item.stop_count = std::abs(s - s1);
-                    item.wait_time = settings_.bus_wait_time;
-                    item.trip_time = (s < s1 ? distance_forward[s1] - distance_forward[s] : distance_reverse[s] - distance_reverse[s1]) / settings_.bus_velocity;
-
-                    int id = graph_.AddEdge(
-                        graph::Edge<double>{
-                        graph_vertexes_[item.start_stop_idx],
-                            graph_vertexes_[item.finish_stop_idx],
-                            item.trip_time + item.wait_time
-                    }
-                    );
-                    graph_edges_.push_back(std::move(item));
-
-                    if (!route->is_roundtrip) {
-                        RouteItem item;
-                        item.start_stop_idx = stops_.at(route->stops[s1]);
-                        item.finish_stop_idx = stops_.at(route->stops[s]);
-                        item.bus = route;
-                        item.stop_count = std::abs(s - s1);
-                        item.wait_time = settings_.bus_wait_time;
-                        item.trip_time = (s1 < s ? distance_forward[s] - distance_forward[s1] : distance_reverse[s1] - distance_reverse[s]) / settings_.bus_velocity;
-
-                        int id = graph_.AddEdge(
-                            graph::Edge<double>{
-                            graph_vertexes_[item.start_stop_idx],
-                                graph_vertexes_[item.finish_stop_idx],
-                                item.trip_time + item.wait_time
-                        }
-                        );
-                        graph_edges_.push_back(std::move(item));
-                    }
+        std::vector<size_t> offsets(lines_.size() + 1, 0);
+        for (size_t i = 0; i < lines_.size(); ++i) {
+            offsets[i + 1] = offsets[i] + CountBusEdges(LineBus(lines_[i]));
+        }
+
+        std::vector<graph::Edge<RouteWeight>> edges(offsets.back());
+        graph_edges_.assign(offsets.back(), RouteItem{});
+
+        parallel::ForEachIndex(lines_.size(), [&](size_t i) {
+            FillBusEdges(lines_[i], edges.begin() + offsets[i], graph_edges_.begin() + offsets[i]);
+        });
+
+        if (settings_.walk_radius > 0) {
+            FillWalkEdges(edges);
+        }
+
+        graph_ = graph::DirectedWeightedGraph<RouteWeight>(stops_.size(), std::move(edges));
+    }
+
+    void TransportRouter::FillWalkEdges(std::vector<graph::Edge<RouteWeight>>& edges) {
+        const auto& positions = stop_grid_.GetPoints();
+        std::vector<std::pair<size_t, double>> nearby;
+
+        for (size_t from = 0; from < positions.size(); ++from) {
+            nearby.clear();
+            stop_grid_.ForEachInRadius(positions[from], settings_.walk_radius, [&nearby, from](size_t to, double distance) {
+                if (to != from) {
+                    nearby.push_back({ to, distance });
                 }
+            });
+            std::sort(nearby.begin(), nearby.end());
+
+            for (const auto& [to, distance] : nearby) {
+                RouteItem item;
+                item.start_stop_idx = static_cast<StopId>(from);
+                item.finish_stop_idx = static_cast<StopId>(to);
+                item.trip_time = distance / settings_.walk_velocity;
+
+                edges.push_back(graph::Edge<RouteWeight>{ item.start_stop_idx, item.finish_stop_idx, ToRouteWeight(item.trip_time) });
+                graph_edges_.push_back(std::move(item));
             }
         }
     }
 
-    std::shared_ptr<std::vector <RouteItem>> TransportRouter::findRoute(const std::string_view from, const std::string_view to) {
-        std::shared_ptr<Stop> stop_from = stops_.at(from);
-        std::shared_ptr<Stop> stop_to = stops_.at(to);
-        if (stop_from == nullptr || stop_to == nullptr) return nullptr;
+    void TransportRouter::IndexWalkEdges() {
+        walk_offsets_.assign(stops_.size() + 1, 0);
+        for (const RouteItem& item : graph_edges_) {
+            if (item.IsWalk()) {
+                ++walk_offsets_[item.start_stop_idx + 1];
+            }
+        }
+        for (size_t stop = 0; stop < stops_.size(); ++stop) {
+            walk_offsets_[stop + 1] += walk_offsets_[stop];
+        }
 
+        walk_edges_.assign(walk_offsets_.back(), 0);
+        std::vector<size_t> next(walk_offsets_.begin(), walk_offsets_.end() - 1);
+        for (graph::EdgeId edge_id = 0; edge_id < graph_edges_.size(); ++edge_id) {
+            if (graph_edges_[edge_id].IsWalk()) {
+                walk_edges_[next[graph_edges_[edge_id].start_stop_idx]++] = edge_id;
+            }
+        }
+    }
+
+    RouteItem TransportRouter::MakeRide(const BusLine& line, size_t from_pos, size_t to_pos) const {
+        const auto& stops = LineBus(line).stops;
+        RouteItem item;
+        item.start_stop_idx = stops[from_pos];
+        item.finish_stop_idx = stops[to_pos];
+        item.bus = line.bus;
+        item.stop_count = from_pos < to_pos ? to_pos - from_pos : from_pos - to_pos;
+        item.wait_time = settings_.bus_wait_time;
+        item.trip_time = (from_pos < to_pos
+            ? line.distance_forward[to_pos] - line.distance_forward[from_pos]
+            : line.distance_reverse[from_pos] - line.distance_reverse[to_pos]) / settings_.bus_velocity;
+        return item;
+    }
+
+    void TransportRouter::FillBusEdges(
+        const BusLine& line,
+        std::vector<graph::Edge<RouteWeight>>::iterator edge_out,
+        std::vector<RouteItem>::iterator item_out
+    ) const {
+        const Bus& bus = LineBus(line);
+        auto emit = [&](size_t from_pos, size_t to_pos) {
+            RouteItem item = MakeRide(line, from_pos, to_pos);
+            *edge_out++ = graph::Edge<RouteWeight>{
+                bus.stops[from_pos],
+                bus.stops[to_pos],
+                ToRouteWeight(item.trip_time + item.wait_time)
+            };
+            *item_out++ = std::move(item);
+        };
+
+        const size_t stop_count = bus.stops.size();
+        for (size_t s = 0; s + 1 < stop_count; s++) {
+            for (size_t s1 = s + 1; s1 < stop_count; s1++) {
+                emit(s, s1);
+                if (!bus.is_roundtrip) {
+                    emit(s1, s);
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<std::vector <RouteItem>> TransportRouter::findRoute(StopId from, StopId to) {
+        return findRoute(std::vector<StopId>{ from, to });
+    }
+
+    std::shared_ptr<std::vector<RouteItem>> TransportRouter::findRoute(const std::vector<StopId>& vertexes, RouteMode mode) {
         std::shared_ptr<std::vector<RouteItem>> res = std::make_shared<std::vector<RouteItem>>();
-        if (stop_from == stop_to)   return res;
+        for (size_t leg = 1; leg < vertexes.size(); ++leg) {
+            if (vertexes[leg - 1] == vertexes[leg]) continue;
 
+            if (mode == RouteMode::FEWEST_TRANSFERS) {
+                std::shared_ptr<std::vector<RouteItem>> rides = BuildFewestTransfersLeg(vertexes[leg - 1], vertexes[leg]);
+                if (rides == nullptr)  return nullptr;
+                res->insert(res->end(), rides->begin(), rides->end());
+                continue;
+            }
 
-        std::shared_ptr<std::vector<size_t>> res_tmp = search_in_graph_->BuildRoute(graph_vertexes_.at(stop_from), graph_vertexes_.at(stop_to));
-        if (res_tmp == nullptr)  return nullptr;
+            std::shared_ptr<std::vector<size_t>> res_tmp = BuildLeg(vertexes[leg - 1], vertexes[leg]);
+            if (res_tmp == nullptr)  return nullptr;
 
-        res->reserve(res_tmp->size());
-        for (auto e = res_tmp->begin(); e != res_tmp->end(); e++) {
-            res->push_back(graph_edges_.at(*e));
+            res->reserve(res->size() + res_tmp->size());
+            for (auto e = res_tmp->begin(); e != res_tmp->end(); e++) {
+                res->push_back(graph_edges_.at(*e));
+            }
         }
         return res;
     }
 
+    std::shared_ptr<std::vector<RouteItem>> TransportRouter::findRoute(const RouteEndpoint& from, const RouteEndpoint& to) {
+        if (std::holds_alternative<StopId>(from) && std::holds_alternative<StopId>(to)) {
+            return findRoute(std::get<StopId>(from), std::get<StopId>(to));
+        }
+
+        std::vector<std::pair<graph::VertexId, RouteWeight>> sources;
+        std::vector<std::pair<graph::VertexId, RouteWeight>> targets;
+        CollectAccessStops(from, sources);
+        CollectAccessStops(to, targets);
+
+        std::optional<seconds> direct_walk;
+        if (std::holds_alternative<geo::Coordinates>(from) && std::holds_alternative<geo::Coordinates>(to)) {
+            direct_walk = geo::GridIndex::Distance(std::get<geo::Coordinates>(from), std::get<geo::Coordinates>(to)) / settings_.walk_velocity;
+        }
+
+        const auto path = graph::FindBestPath(graph_, sources, targets);
+        auto res = std::make_shared<std::vector<RouteItem>>();
+
+        if (direct_walk && (!path || ToRouteWeight(*direct_walk) <= path->weight)) {
+            RouteItem walk;
+            walk.trip_time = *direct_walk;
+            res->push_back(std::move(walk));
+            return res;
+        }
+        if (!path) return nullptr;
+
+        if (std::holds_alternative<geo::Coordinates>(from)) {
+            RouteItem access;
+            access.finish_stop_idx = static_cast<StopId>(path->source);
+            access.trip_time = geo::GridIndex::Distance(std::get<geo::Coordinates>(from), stops_[access.finish_stop_idx].coordinates) / settings_.walk_velocity;
+            res->push_back(std::move(access));
+        }
+        for (const graph::EdgeId edge_id : path->edges) {
+            res->push_back(graph_edges_.at(edge_id));
+        }
+        if (std::holds_alternative<geo::Coordinates>(to)) {
+            RouteItem egress;
+            egress.start_stop_idx = static_cast<StopId>(path->target);
+            egress.trip_time = geo::GridIndex::Distance(stops_[egress.start_stop_idx].coordinates, std::get<geo::Coordinates>(to)) / settings_.walk_velocity;
+            res->push_back(std::move(egress));
+        }
+        return res;
+    }
+
+    void TransportRouter::CollectAccessStops(const RouteEndpoint& point, std::vector<std::pair<graph::VertexId, RouteWeight>>& stops) const {
+        if (const auto* stop = std::get_if<StopId>(&point)) {
+            stops.push_back({ *stop, RouteWeight{} });
+            return;
+        }
+
+        for (const auto& [vertex, distance] : stop_grid_.Nearest(std::get<geo::Coordinates>(point), ACCESS_STOP_COUNT)) {
+            stops.push_back({ static_cast<graph::VertexId>(vertex), ToRouteWeight(distance / settings_.walk_velocity) });
+        }
+    }
+
+    std::shared_ptr<std::vector<size_t>> TransportRouter::BuildLeg(size_t vertex_from, size_t vertex_to) const {
+        return search_in_graph_
+            ? search_in_graph_->BuildRoute(vertex_from, vertex_to)
+            : overlay_->BuildRoute(vertex_from, vertex_to);
+    }
+
+    // Round-based search over the stop-bus incidence: round k holds the best time to every stop
+    // using at most k buses, and only lines through stops improved in round k - 1 are scanned.
+    // Footpaths are relaxed after every round without counting as a bus.
+    // The first round that reaches the target gives the fewest buses and the best time among them.
+    std::shared_ptr<std::vector<RouteItem>> TransportRouter::BuildFewestTransfersLeg(size_t vertex_from, size_t vertex_to) const {
+        constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+
+        struct Step {
+            std::optional<size_t> walk_edge;
+            size_t line = 0;
+            size_t from_pos = 0;
+            size_t to_pos = 0;
+        };
+
+        const size_t vertex_count = stops_.size();
+        std::vector<double> best(vertex_count, UNREACHED);
+        std::vector<std::vector<double>> arrival;
+        std::vector<std::vector<std::optional<Step>>> steps;
+        std::vector<bool> line_queued(lines_.size(), false);
+
+        std::vector<double> previous(vertex_count, UNREACHED);
+        std::vector<double> current = previous;
+        std::vector<std::optional<Step>> current_steps(vertex_count);
+        std::vector<size_t> improved;
+
+        auto improve = [&](size_t vertex, double time, const Step& step) {
+            if (time >= best[vertex]) {
+                return false;
+            }
+            if (current[vertex] == previous[vertex]) {
+                improved.push_back(vertex);
+            }
+            best[vertex] = time;
+            current[vertex] = time;
+            current_steps[vertex] = step;
+            return true;
+        };
+
+        auto walk = [&]() {
+            using QueueItem = std::pair<double, size_t>;
+            std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+            for (const size_t vertex : improved) {
+                queue.push({ current[vertex], vertex });
+            }
+            while (!queue.empty()) {
+                const auto [time, vertex] = queue.top();
+                queue.pop();
+                if (time != current[vertex]) continue;
+
+                for (size_t walk = walk_offsets_[vertex]; walk < walk_offsets_[vertex + 1]; ++walk) {
+                    const graph::EdgeId edge_id = walk_edges_[walk];
+                    const RouteItem& item = graph_edges_[edge_id];
+                    const size_t to = graph_.GetEdge(edge_id).to;
+                    if (improve(to, time + item.trip_time, Step{ edge_id })) {
+                        queue.push({ current[to], to });
+                    }
+                }
+            }
+        };
+
+        best[vertex_from] = 0.0;
+        current[vertex_from] = 0.0;
+        improved.push_back(vertex_from);
+        walk();
+
+        while (true) {
+            arrival.push_back(std::move(current));
+            steps.push_back(std::move(current_steps));
+            if (improved.empty() || best[vertex_to] != UNREACHED) break;
+
+            previous = arrival.back();
+            current = previous;
+            current_steps.assign(vertex_count, std::nullopt);
+
+            std::vector<size_t> queue;
+            for (const size_t vertex : improved) {
+                for (const BusId line : stops_[vertex].buses) {
+                    if (!line_queued[line]) {
+                        line_queued[line] = true;
+                        queue.push_back(line);
+                    }
+                }
+            }
+            std::sort(queue.begin(), queue.end());
+            improved.clear();
+
+            for (const size_t line_id : queue) {
+                line_queued[line_id] = false;
+                const BusLine& line = lines_[line_id];
+                const Bus& bus = LineBus(line);
+                const size_t stop_count = bus.stops.size();
+
+                double board_key = UNREACHED;
+                size_t board_pos = 0;
+                for (size_t pos = 0; pos < stop_count; ++pos) {
+                    if (board_key != UNREACHED) {
+                        improve(bus.stops[pos], board_key + line.distance_forward[pos] / settings_.bus_velocity,
+                            Step{ std::nullopt, line_id, board_pos, pos });
+                    }
+                    const double key = previous[bus.stops[pos]] + settings_.bus_wait_time
+                        - line.distance_forward[pos] / settings_.bus_velocity;
+                    if (key < board_key) {
+                        board_key = key;
+                        board_pos = pos;
+                    }
+                }
+
+                if (bus.is_roundtrip) continue;
+
+                board_key = UNREACHED;
+                for (size_t pos = stop_count; pos-- > 0;) {
+                    if (board_key != UNREACHED) {
+                        improve(bus.stops[pos], board_key - line.distance_reverse[pos] / settings_.bus_velocity,
+                            Step{ std::nullopt, line_id, board_pos, pos });
+                    }
+                    const double key = previous[bus.stops[pos]] + settings_.bus_wait_time
+                        + line.distance_reverse[pos] / settings_.bus_velocity;
+                    if (key < board_key) {
+                        board_key = key;
+                        board_pos = pos;
+                    }
+                }
+            }
+
+            walk();
+        }
+
+        if (best[vertex_to] == UNREACHED) return nullptr;
+
+        auto res = std::make_shared<std::vector<RouteItem>>();
+        size_t vertex = vertex_to;
+        for (size_t round = steps.size() - 1; vertex != vertex_from;) {
+            if (!steps[round][vertex]) {
+                --round;
+                continue;
+            }
+            const Step& step = *steps[round][vertex];
+            if (step.walk_edge) {
+                res->push_back(graph_edges_[*step.walk_edge]);
+                vertex = graph_.GetEdge(*step.walk_edge).from;
+            }
+            else {
+                res->push_back(MakeRide(lines_[step.line], step.from_pos, step.to_pos));
+                vertex = LineBus(lines_[step.line]).stops[step.from_pos];
+                --round;
+            }
+        }
+        std::reverse(res->begin(), res->end());
+        return res;
+    }
+
     const RoutingSettings& TransportRouter::GetSettings() const {
         return settings_;
     }
 
     void TransportRouter::SerializeData(TCProto::TransportRouter& proto) const {
         graph_.Serialize(*proto.mutable_graph());
-        search_in_graph_->Serialize(*proto.mutable_router());
+        if (search_in_graph_) {
+            search_in_graph_->Serialize(*proto.mutable_router());
+        }
+        else {
+            overlay_->Serialize(*proto.mutable_overlay());
+        }
 
         for (const auto& item : graph_edges_) {
             TCProto::RouteItem& proto_edge = *proto.add_graph_edges();
-            proto_edge.set_start_stop(item.start_stop_idx->name);
-            proto_edge.set_finish_stop(item.finish_stop_idx->name);
-            proto_edge.set_bus(item.bus->name);
+            proto_edge.set_start_stop_id(item.start_stop_idx);
+            proto_edge.set_finish_stop_id(item.finish_stop_idx);
+            if (item.IsWalk()) {
+                proto_edge.set_walk(true);
+            }
+            else {
+                proto_edge.set_bus_id(item.bus);
+            }
             proto_edge.set_stop_count(item.stop_count);
             proto_edge.set_trip_time(item.trip_time);
             proto_edge.set_wait_time(item.wait_time);
         }
-
-        for (const auto& [name, value] : graph_vertexes_) {
-            TCProto::GraphVertexes& proto_vertex = *proto.add_graph_vertexes();
-            proto_vertex.set_stop_name(name->name);
-            proto_vertex.set_index(value);
-        }
-
     }
 
     void TransportRouter::DeserializeData(const TCProto::TransportRouter& proto) {
-        graph_ = graph::DirectedWeightedGraph<double>::Deserialize(proto.graph());
-       
+        graph_ = graph::DirectedWeightedGraph<RouteWeight>::Deserialize(proto.graph());
+        if (graph_.GetVertexCount() != stops_.size() || graph_.GetEdgeCount() != static_cast<size_t>(proto.graph_edges_size())) {
+            throw std::runtime_error("invalid serialized router");
+        }
+
+        graph_edges_.reserve(proto.graph_edges_size());
         for (const auto& proto_edge : proto.graph_edges()) {
+            // The walk edges are indexed by their start stop.
+            if (proto_edge.start_stop_id() >= stops_.size() || (!proto_edge.walk() && proto_edge.bus_id() >= buses_.size())) {
+                throw std::runtime_error("invalid serialized router");
+            }
             RouteItem tmp;
-            tmp.start_stop_idx = stops_.at(proto_edge.start_stop());
-            tmp.finish_stop_idx = stops_.at(proto_edge.finish_stop());
-            tmp.bus = buses_.at(proto_edge.bus());
+            tmp.start_stop_idx = proto_edge.start_stop_id();
+            tmp.finish_stop_idx = proto_edge.finish_stop_id();
+            tmp.bus = proto_edge.walk() ? NO_ID : proto_edge.bus_id();
             tmp.stop_count = proto_edge.stop_count();
             tmp.wait_time = proto_edge.wait_time();
             tmp.trip_time = proto_edge.trip_time();
@@ -160,11 +491,14 @@ namespace transport::router {
             graph_edges_.push_back(std::move(tmp));
 
         }
+        FillLines();
+        IndexWalkEdges();
 
-        for (const auto& proto_vertex : proto.graph_vertexes()) {
-            graph_vertexes_[ stops_.at(proto_vertex.stop_name()) ] = proto_vertex.index();
+        if (proto.has_overlay()) {
+            overlay_ = graph::OverlayRouter<RouteWeight>::Deserialize(proto.overlay(), graph_);
+        }
+        else {
+            search_in_graph_ = graph::Router<RouteWeight>::Deserialize(proto.router(), graph_);
         }
-
-        search_in_graph_ = graph::Router<double>::Deserialize(proto.router(), graph_);
     }
 }
\ No newline at end of file
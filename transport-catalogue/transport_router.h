@@ -1,6 +1,9 @@
 #pragma once
 
 #include "domain.h"
+#include "geo_index.h"
+#include "graph_search.h"
+#include "overlay_router.h"
 #include "router.h"
 
 #include "transport_router.pb.h"
@@ -12,9 +15,11 @@
 #include <ostream>
 #include <vector>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <algorithm>
 #include <memory>
+#include <variant>
 
 
 
@@ -27,7 +32,31 @@ namespace transport::router {
 
     using km_ch = double;
     using m_c = double;
+    using meters = double;
 
+    // Graph weights are fixed-point tenths of a second: exact comparisons and half the width of double.
+    using RouteWeight = uint32_t;
+    inline constexpr double ROUTE_WEIGHT_PER_SECOND = 10.0;
+
+    inline RouteWeight ToRouteWeight(seconds time) {
+        return static_cast<RouteWeight>(std::llround(time * ROUTE_WEIGHT_PER_SECOND));
+    }
+
+
+    // TABLE keeps the all-pairs graph::Router table, OVERLAY the multi-level graph::OverlayRouter;
+    // AUTO picks the overlay once the table would grow too large.
+    enum class RoutingEngine {
+        AUTO, TABLE, OVERLAY
+    };
+
+    inline constexpr size_t OVERLAY_MIN_STOP_COUNT = 2000;
+    inline constexpr double STOP_GRID_CELL_SIZE = 500.0;
+    inline constexpr size_t ACCESS_STOP_COUNT = 4;
+
+    // TIME minimizes the total trip time, FEWEST_TRANSFERS the number of buses with time as a tiebreaker.
+    enum class RouteMode {
+        TIME, FEWEST_TRANSFERS
+    };
 
     struct RoutingSettings {
         RoutingSettings() = default;
@@ -38,14 +67,19 @@ namespace transport::router {
 
         seconds bus_wait_time;
         m_c bus_velocity;
+        RoutingEngine engine = RoutingEngine::AUTO;
+
+        // Stops closer than walk_radius get footpath edges; zero disables walking.
+        meters walk_radius = 0.0;
+        m_c walk_velocity = 5.0 / 3.6;
     };
 
 
     struct RouteItem {
         RouteItem() = default;
-        RouteItem(std::shared_ptr<Stop> start_stop, 
-            std::shared_ptr<Stop> finish_stop, 
-            std::shared_ptr<Bus> new_bus, 
+        RouteItem(StopId start_stop, 
+            StopId finish_stop, 
+            BusId new_bus, 
             int new_trip_stop_count, 
             seconds new_trip_time, 
             seconds new_wait_time
@@ -60,30 +94,44 @@ namespace transport::router {
 
         }
 
-        std::shared_ptr<Stop> start_stop_idx = nullptr;
-        std::shared_ptr<Stop> finish_stop_idx = nullptr;
-        std::shared_ptr<Bus> bus = nullptr;
+        StopId start_stop_idx = NO_ID;
+        StopId finish_stop_idx = NO_ID;
+        // NO_ID for a walk; a walk from or to a raw position has no start or finish stop
+        BusId bus = NO_ID;
         
         int stop_count = 0;
         seconds trip_time = 0.0;
         seconds wait_time = 0.0;
+
+        bool IsWalk() const {
+            return bus == NO_ID;
+        }
     };
 
 
 
+    // A route endpoint: a stop name or a raw position.
+    using RoutePoint = std::variant<std::string_view, geo::Coordinates>;
+    // The same with the stop looked up.
+    using RouteEndpoint = std::variant<StopId, geo::Coordinates>;
+
+    // Graph vertexes are stop ids and lines are bus ids.
     class TransportRouter {
     public:
        
         TransportRouter(
-            std::map<std::string_view, std::shared_ptr<Stop>>& stops,
-            std::map<std::string_view, std::shared_ptr<Bus>>& buses, 
+            const std::vector<Stop>& stops,
+            const std::vector<Bus>& buses, 
+            const RoadDistances& distances,
             RoutingSettings settings);
 
         void BuildGraph();
 
         const RoutingSettings& GetSettings() const;
 
-        std::shared_ptr<std::vector<RouteItem>> findRoute(const std::string_view from, const std::string_view to);
+        std::shared_ptr<std::vector<RouteItem>> findRoute(StopId from, StopId to);
+        std::shared_ptr<std::vector<RouteItem>> findRoute(const std::vector<StopId>& waypoints, RouteMode mode = RouteMode::TIME);
+        std::shared_ptr<std::vector<RouteItem>> findRoute(const RouteEndpoint& from, const RouteEndpoint& to);
 
 
         void SerializeSettings(TCProto::RoutingSettings& proto);
@@ -94,18 +142,51 @@ namespace transport::router {
         void DeserializeData(const TCProto::TransportRouter& proto);
 
     private:
-        const std::map<std::string_view, std::shared_ptr<Stop>>& stops_;
-        const std::map<std::string_view, std::shared_ptr<Bus>>& buses_;
+        const std::vector<Stop>& stops_;
+        const std::vector<Bus>& buses_;
+        const RoadDistances& distances_;
         const RoutingSettings settings_;
 
-        graph::DirectedWeightedGraph<double> graph_;
-        std::unique_ptr<graph::Router<double>> search_in_graph_ = nullptr;
+        graph::DirectedWeightedGraph<RouteWeight> graph_;
+        std::unique_ptr<graph::Router<RouteWeight>> search_in_graph_ = nullptr;
+        std::unique_ptr<graph::OverlayRouter<RouteWeight>> overlay_ = nullptr;
 
         std::vector<RouteItem> graph_edges_;
-        std::unordered_map<std::shared_ptr<Stop>, size_t> graph_vertexes_;
 
-        void FillVertexes();
+        // One bus with cumulative road distances between its stops in both directions.
+        struct BusLine {
+            BusId bus = NO_ID;
+            std::vector<double> distance_forward;
+            std::vector<double> distance_reverse;
+        };
+
+        std::vector<BusLine> lines_;
+        geo::GridIndex stop_grid_;
+
+        // Walk edges by start stop, apart from the many bus edges: those of stop s are
+        // walk_edges_[walk_offsets_[s]] up to walk_edges_[walk_offsets_[s + 1]].
+        std::vector<size_t> walk_offsets_;
+        std::vector<graph::EdgeId> walk_edges_;
+
+        void FillLines();
         void FillEdges();
+        void FillWalkEdges(std::vector<graph::Edge<RouteWeight>>& edges);
+        void IndexWalkEdges();
+        bool UseOverlay() const;
+        std::shared_ptr<std::vector<size_t>> BuildLeg(size_t vertex_from, size_t vertex_to) const;
+        std::shared_ptr<std::vector<RouteItem>> BuildFewestTransfersLeg(size_t vertex_from, size_t vertex_to) const;
+        void CollectAccessStops(const RouteEndpoint& point, std::vector<std::pair<graph::VertexId, RouteWeight>>& stops) const;
+
+        RouteItem MakeRide(const BusLine& line, size_t from_pos, size_t to_pos) const;
+        const Bus& LineBus(const BusLine& line) const {
+            return buses_[line.bus];
+        }
+        static size_t CountBusEdges(const Bus& route);
+        void FillBusEdges(
+            const BusLine& line,
+            std::vector<graph::Edge<RouteWeight>>::iterator edge_out,
+            std::vector<RouteItem>::iterator item_out
+        ) const;
     };
 
 }
\ No newline at end of file